@@ -0,0 +1,83 @@
+#ifndef CHESS_ATTACKS_H
+#define CHESS_ATTACKS_H
+
+#include "bitboard.h"
+#include "piece.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+/**
+ * @brief Precomputed attack tables for every piece type
+ *
+ * Leaper attacks are plain 64-entry tables. Slider attacks use magic bitboards:
+ * the relevant blockers of a square are hashed into a per-square slice of one
+ * shared table. When built for a BMI2 target (e.g. -mbmi2 or -march=native),
+ * PEXT replaces the magic multiply as the hash.
+ *
+ * The tables are built once at program startup.
+ */
+namespace attacks {
+
+// Lookup data for one square of one slider type
+struct Magic {
+    Bitboard mask;      // relevant blocker squares (rays without the board edge)
+    Bitboard magic;     // multiplier that maps each blocker subset to a unique index
+    Bitboard* table;    // start of this square's slice of the attack table
+    unsigned shift;     // 64 - number of relevant bits
+    
+    unsigned index(Bitboard occupied) const {
+#if defined(__BMI2__)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Bitboard pawnTable[3][64];   // indexed by Color, then square
+extern Bitboard knightTable[64];
+extern Bitboard kingTable[64];
+extern Magic bishopMagics[64];
+extern Magic rookMagics[64];
+extern Bitboard betweenTable[64][64];
+extern Bitboard lineTable[64][64];
+
+// Build all tables (done automatically before main, calling it again is harmless)
+void init();
+
+// Squares attacked by a pawn of the given color standing on square
+inline Bitboard pawnAttacks(Color color, int square) { return pawnTable[static_cast<int>(color)][square]; }
+
+inline Bitboard knightAttacks(int square) { return knightTable[square]; }
+
+inline Bitboard kingAttacks(int square) { return kingTable[square]; }
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+    const Magic& m = bishopMagics[square];
+    return m.table[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int square, Bitboard occupied) {
+    const Magic& m = rookMagics[square];
+    return m.table[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+// Squares strictly between two squares on a shared rank, file or diagonal (empty otherwise)
+inline Bitboard between(int from, int to) { return betweenTable[from][to]; }
+
+// The whole rank, file or diagonal through two squares (empty if they don't share one)
+inline Bitboard line(int from, int to) { return lineTable[from][to]; }
+
+} // namespace attacks
+
+} // namespace chess
+
+#endif // CHESS_ATTACKS_H
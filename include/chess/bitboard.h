@@ -0,0 +1,41 @@
+#ifndef CHESS_BITBOARD_H
+#define CHESS_BITBOARD_H
+
+#include <cstdint>
+
+namespace chess {
+
+// A set of squares, one bit per square (a1 = bit 0, h8 = bit 63)
+using Bitboard = uint64_t;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard RANK_1_BB = 0x00000000000000FFULL;
+
+// Bitboard with only the given square set
+inline Bitboard squareBB(int square) { return 1ULL << square; }
+
+// All squares on a file (0-7)
+inline Bitboard fileBB(int file) { return FILE_A_BB << file; }
+
+// All squares on a rank (0-7)
+inline Bitboard rankBB(int rank) { return RANK_1_BB << (8 * rank); }
+
+// Number of squares in the set
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+
+// Index of the lowest square in a non-empty set
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+
+// Index of the highest square in a non-empty set
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+
+// Remove and return the lowest square of a non-empty set
+inline int popLsb(Bitboard& b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+} // namespace chess
+
+#endif // CHESS_BITBOARD_H
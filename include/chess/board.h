@@ -1,9 +1,13 @@
 #ifndef CHESS_BOARD_H
 #define CHESS_BOARD_H
 
+#include "bitboard.h"
 #include "piece.h"
 #include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace chess {
@@ -26,6 +30,12 @@ struct Position {
     // Create from algebraic notation
     static Position fromAlgebraic(const std::string& algebraic);
     
+    // Convert to a square index (a1 = 0, b1 = 1, ..., h8 = 63)
+    int toIndex() const { return rank * 8 + file; }
+    
+    // Create from a square index
+    static Position fromIndex(int index) { return Position(index & 7, index >> 3); }
+    
     bool operator==(const Position& other) const {
         return file == other.file && rank == other.rank;
     }
@@ -35,108 +45,337 @@ struct Position {
     }
 };
 
-// A move from one position to another
-struct Move {
-    Position from;
-    Position to;
-    PieceType promotion; // For pawn promotion
+// A move from one position to another, packed into 16 bits:
+// bits 0-5 from square, 6-11 to square, 12-13 promotion piece (knight..queen), 14-15 flag
+class Move {
+public:
+    enum Flag : uint16_t {
+        NORMAL     = 0,
+        PROMOTION  = 1,
+        EN_PASSANT = 2,
+        CASTLING   = 3
+    };
+    
+private:
+    uint16_t data;
     
-    Move() : from(), to(), promotion(PieceType::EMPTY) {}
+public:
+    Move() : data(0) {}
     Move(Position from, Position to, PieceType promotion = PieceType::EMPTY)
-        : from(from), to(to), promotion(promotion) {}
+        : Move(from.toIndex(), to.toIndex(),
+               promotion == PieceType::EMPTY ? NORMAL : PROMOTION, promotion) {}
+    Move(int fromSquare, int toSquare, Flag flag = NORMAL, PieceType promotion = PieceType::EMPTY)
+        : data(static_cast<uint16_t>(fromSquare | (toSquare << 6) | (flag << 14) |
+               (flag == PROMOTION ? (static_cast<int>(promotion) - static_cast<int>(PieceType::KNIGHT)) << 12 : 0))) {}
+    
+    int fromSquare() const { return data & 63; }
+    int toSquare() const { return (data >> 6) & 63; }
+    Position from() const { return Position::fromIndex(fromSquare()); }
+    Position to() const { return Position::fromIndex(toSquare()); }
+    Flag flag() const { return static_cast<Flag>(data >> 14); }
+    
+    // Promotion piece, or EMPTY if this isn't a promotion
+    PieceType promotion() const {
+        return flag() == PROMOTION
+            ? static_cast<PieceType>(((data >> 12) & 3) + static_cast<int>(PieceType::KNIGHT))
+            : PieceType::EMPTY;
+    }
+    
+    // The default constructed move (a1a1) doubles as "no move"
+    bool isNull() const { return data == 0; }
+    
+    // Raw 16-bit encoding, e.g. for hash table entries
+    uint16_t raw() const { return data; }
+    static Move fromRaw(uint16_t raw) {
+        Move move;
+        move.data = raw;
+        return move;
+    }
     
     // Convert to algebraic notation (e.g., "e2e4")
     std::string toAlgebraic() const;
     
-    // Create from algebraic notation
+    // Create from algebraic notation (flags are not known without a board, see Board::makeMove)
     static Move fromAlgebraic(const std::string& algebraic);
     
-    bool operator==(const Move& other) const {
-        return from == other.from && to == other.to && promotion == other.promotion;
-    }
+    bool operator==(const Move& other) const { return data == other.data; }
+    bool operator!=(const Move& other) const { return data != other.data; }
+};
+
+// Fixed-capacity list of moves that lives on the stack (no position has more than 218 legal moves)
+class MoveList {
+public:
+    static constexpr int CAPACITY = 256;
+    
+private:
+    std::array<Move, CAPACITY> moves;
+    int count;
+    
+public:
+    MoveList() : count(0) {}
+    
+    void push_back(const Move& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    
+    Move& operator[](int index) { return moves[index]; }
+    const Move& operator[](int index) const { return moves[index]; }
+    
+    Move* begin() { return moves.data(); }
+    Move* end() { return moves.data() + count; }
+    const Move* begin() const { return moves.data(); }
+    const Move* end() const { return moves.data() + count; }
+};
+
+// Castling rights, stored together as a bitmask
+enum CastlingRight : uint8_t {
+    WHITE_KINGSIDE  = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE  = 4,
+    BLACK_QUEENSIDE = 8
+};
+
+// Which part of the legal moves to generate
+enum class MoveGenType {
+    ALL,
+    CAPTURES,       // captures, en passant and promotions
+    QUIETS          // everything else, castling included
 };
 
+// Everything makeMove changes that can't be recomputed, so unmakeMove can restore it
+struct UndoInfo {
+    Move move;
+    Piece moved;            // piece that moved (a pawn for promotions)
+    Piece captured;         // piece that was on the target square, if any
+    uint8_t castlingRights;
+    Position enPassantTarget;
+    int halfMoveClock;
+    uint64_t hash;          // Zobrist key before the move
+};
+
+struct PackedPosition;
+
 // The chess board
 class Board {
 private:
-    std::array<std::array<Piece, 8>, 8> pieces;
+    std::array<Piece, 64> mailbox;        // piece on each square, indexed by Position::toIndex
+    std::array<Bitboard, 7> typeBB;       // squares occupied by each PieceType (EMPTY unused)
+    std::array<Bitboard, 3> colorBB;      // squares occupied by each Color (NONE unused)
     Color sideToMove;
-    bool whiteCanCastleKingside;
-    bool whiteCanCastleQueenside;
-    bool blackCanCastleKingside;
-    bool blackCanCastleQueenside;
+    uint8_t castlingRights;               // CastlingRight bits
     Position enPassantTarget;
     int halfMoveClock;
     int fullMoveNumber;
+    uint64_t key;                         // Zobrist hash, kept up to date incrementally
+    uint64_t pawnKey;                     // Zobrist hash of the pawns only
+    int mgScore;                          // material + piece-square sum (white - black), midgame
+    int egScore;                          // the same for the endgame
+    int phase;                            // non-pawn material left, psqt::MAX_PHASE at the start
+    std::vector<UndoInfo> undoStack;      // one entry per move made on this board
 
 public:
+    // Room writeFEN needs, terminating zero included
+    static constexpr size_t MAX_FEN_LENGTH = 128;
+    
     // Initialize an empty board
     Board();
     
-    // Initialize from FEN string
+    // Initialize from FEN string (throws std::invalid_argument if it can't be parsed)
     Board(const std::string& fen);
     
+    // Set up the position from a FEN string, reusing this board's memory so bulk loading
+    // doesn't allocate. The move counters may be left out. Returns false and leaves the
+    // board empty if the FEN is malformed
+    bool loadFEN(std::string_view fen);
+    
+    // Set up the position from its packed form (see packed.h), false and an empty board if
+    // it's malformed
+    bool loadPacked(const PackedPosition& packed);
+    
     // Get piece at position
     Piece getPiece(const Position& pos) const;
     
     // Set piece at position
     void setPiece(const Position& pos, const Piece& piece);
     
+    // Get all squares holding pieces of a type and color
+    Bitboard getPieces(PieceType type, Color color) const {
+        return typeBB[static_cast<int>(type)] & colorBB[static_cast<int>(color)];
+    }
+    
+    // Get all squares holding pieces of a type (both colors)
+    Bitboard getPieces(PieceType type) const { return typeBB[static_cast<int>(type)]; }
+    
+    // Get all squares holding pieces of a color
+    Bitboard getPieces(Color color) const { return colorBB[static_cast<int>(color)]; }
+    
+    // Get all occupied squares
+    Bitboard getOccupied() const {
+        return colorBB[static_cast<int>(Color::WHITE)] | colorBB[static_cast<int>(Color::BLACK)];
+    }
+    
+    // Get the king position of a color (invalid if there is no king)
+    Position getKingPosition(Color color) const;
+    
     // Get the side to move
     Color getSideToMove() const { return sideToMove; }
     
     // Set the side to move
-    void setSideToMove(Color color) { sideToMove = color; }
+    void setSideToMove(Color color) { if (color != sideToMove) toggleSideToMove(); }
     
     // Toggle the side to move
-    void toggleSideToMove() { sideToMove = (sideToMove == Color::WHITE) ? Color::BLACK : Color::WHITE; }
+    void toggleSideToMove();
+    
+    // Get the Zobrist hash of the position (pieces, side to move, castling rights, en passant file)
+    uint64_t hash() const { return key; }
+    
+    // Get the Zobrist hash of the pawns alone (both colors), for caching pawn structure
+    uint64_t pawnHash() const { return pawnKey; }
+    
+    // Get the midgame material + piece-square score from white's point of view
+    int getMidgameScore() const { return mgScore; }
+    
+    // Get the endgame material + piece-square score from white's point of view
+    int getEndgameScore() const { return egScore; }
+    
+    // Get the game phase (psqt::MAX_PHASE with all pieces on, 0 with only pawns and kings)
+    int getPhase() const { return phase; }
+    
+    // Get the castling rights (CastlingRight bits)
+    uint8_t getCastlingRights() const { return castlingRights; }
+    
+    // Get the en passant target square (invalid if there is none)
+    Position getEnPassantTarget() const { return enPassantTarget; }
+    
+    // Get the number of half moves since the last capture or pawn move
+    int getHalfMoveClock() const { return halfMoveClock; }
+    
+    // Get the full move number (starts at 1, incremented after black moves)
+    int getFullMoveNumber() const { return fullMoveNumber; }
     
     // Get the FEN string for the current board
     std::string toFEN() const;
     
+    // Write the FEN into buffer (MAX_FEN_LENGTH chars at least) with a terminating zero,
+    // returns its length
+    size_t writeFEN(char* buffer) const;
+    
+    // Pack the position into 32 bytes, false if it doesn't fit (more than 32 pieces)
+    bool writePacked(PackedPosition& packed) const;
+    
     // Print the board to the console
     void print() const;
     
-    // Make a move on the board
+    // Make a move on the board (returns false and leaves the board untouched if illegal)
     bool makeMove(const Move& move);
     
+    // Make a move known to be legal (e.g. straight from generateLegalMoves) without
+    // validating it; used by the search, GUI/binding input should go through makeMove
+    void makeMoveUnchecked(const Move& move);
+    
+    // Take back the last move made with makeMove or makeMoveUnchecked
+    void unmakeMove();
+    
+    // Pass the turn without moving (for null move pruning). Positions before the null move
+    // don't count for repetitions, and it must be taken back with unmakeNullMove
+    void makeNullMove();
+    void unmakeNullMove();
+    
+    // Get the last move made, a null Move if there is none (or it was a null move)
+    Move getLastMove() const { return undoStack.empty() ? Move() : undoStack.back().move; }
+    
     // Check if a position is under attack by a specific color
     bool isUnderAttack(const Position& pos, Color attackingColor) const;
     
     // Check if the current side to move is in check
     bool isInCheck() const;
     
-    // Generate all legal moves for the current side to move
-    std::vector<Move> generateLegalMoves() const;
+    // Get the pieces of both colors attacking a square, with sliders seeing through
+    // everything not in occupied
+    Bitboard getAttackers(int square, Bitboard occupied) const;
+    
+    // Get the pieces of a color that are pinned to their own king
+    Bitboard getPinnedPieces(Color color) const;
+    
+    // Static exchange evaluation: material won or lost (in centipawns) on the target square
+    // if both sides keep recapturing with their least valuable piece while it pays off
+    int see(const Move& move) const;
+    
+    // Check if a move takes something (en passant included)
+    bool isCapture(const Move& move) const {
+        return move.flag() == Move::EN_PASSANT || !mailbox[move.toSquare()].isEmpty();
+    }
+    
+    // Generate the legal moves for the current side to move (all of them, or only the
+    // captures or quiets so a search can generate in stages)
+    MoveList generateLegalMoves(MoveGenType type = MoveGenType::ALL) const;
     
     // Generate all pseudo-legal moves for a specific piece
-    std::vector<Move> generatePseudoLegalMoves(const Position& pos) const;
+    MoveList generatePseudoLegalMoves(const Position& pos) const;
     
     // Check if a move is legal
     bool isLegalMove(const Move& move) const;
     
+    // Check if the fifty move rule applies (100 half moves without a capture or pawn move)
+    bool isFiftyMoveDraw() const { return halfMoveClock >= 100; }
+    
+    // Check if neither side has enough material left to deliver mate
+    bool hasInsufficientMaterial() const;
+    
+    // Check if the current position occurred before, at least `times` times, since the
+    // last capture or pawn move (1 is what a search wants, 2 is threefold repetition)
+    bool isRepetition(int times = 1) const;
+    
+    // Check if the position is drawn by rule (fifty moves, insufficient material or threefold repetition)
+    bool isDraw() const;
+    
+    // Count the leaf nodes of the legal move tree to the given depth (movegen testing)
+    uint64_t perft(int depth);
+    
+    // Perft split by root move, to find which move a wrong count comes from
+    std::vector<std::pair<Move, uint64_t>> divide(int depth);
+    
 private:
+    // Remove everything from the board, white to move, keeping the undo stack's memory
+    void reset();
+    
+    // Hash of the en passant square, only counted when the side to move can actually capture there
+    uint64_t enPassantKey() const;
+    
+    // Compute the Zobrist hash from scratch
+    uint64_t computeHash() const;
+    
+    // Hash of everything but the pieces (side to move, castling rights, en passant)
+    uint64_t stateKey() const;
+    
+    // Append the pseudo-legal moves of the piece on pos
+    void generatePieceMoves(const Position& pos, MoveList& moves) const;
+    
     // Generate pawn moves
-    void generatePawnMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generatePawnMoves(const Position& pos, MoveList& moves) const;
     
     // Generate knight moves
-    void generateKnightMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generateKnightMoves(const Position& pos, MoveList& moves) const;
     
     // Generate bishop moves
-    void generateBishopMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generateBishopMoves(const Position& pos, MoveList& moves) const;
     
     // Generate rook moves
-    void generateRookMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generateRookMoves(const Position& pos, MoveList& moves) const;
     
     // Generate queen moves
-    void generateQueenMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generateQueenMoves(const Position& pos, MoveList& moves) const;
     
     // Generate king moves
-    void generateKingMoves(const Position& pos, std::vector<Move>& moves) const;
+    void generateKingMoves(const Position& pos, MoveList& moves) const;
+    
+    // Add a move from pos to every square in targets that isn't one of our own pieces
+    void addMoves(const Position& pos, Bitboard targets, MoveList& moves) const;
     
-    // Generate sliding piece moves (bishop, rook, queen)
-    void generateSlidingMoves(const Position& pos, const std::vector<std::pair<int, int>>& directions, 
-                             std::vector<Move>& moves) const;
+    // Add a move from a square to every square in targets
+    void addMoves(int from, Bitboard targets, MoveList& moves) const;
 };
 
 } // namespace chess
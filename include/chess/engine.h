@@ -3,38 +3,234 @@
 
 #include "board.h"
 #include "evaluate.h"
+#include "movepick.h"
+#include "transposition.h"
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace chess {
 
+// What a search is allowed to spend, anything left at 0 means no limit
+struct SearchLimits {
+    int depth = 0;              // maximum depth in plies
+    int64_t movetime = 0;       // exact time for this move in ms
+    int64_t wtime = 0;          // clock time left in ms
+    int64_t btime = 0;
+    int64_t winc = 0;           // increment per move in ms
+    int64_t binc = 0;
+    int movestogo = 0;          // moves until the next time control (0 = sudden death)
+    uint64_t nodes = 0;         // node budget
+    bool infinite = false;      // ignore the clock and search until stop()
+};
+
+// Progress report sent after each completed iteration
+struct SearchInfo {
+    int depth;
+    int score;                  // centipawns from the side to move's point of view
+    int mate;                   // moves until mate (negative when getting mated), 0 if score isn't a mate
+    uint64_t nodes;
+    int64_t time;               // ms since the search started
+    int hashfull;               // permille of the transposition table used by this search
+    Move bestMove;
+    std::vector<Move> pv;       // principal variation, starting with bestMove
+};
+
+class Engine;
+
+/**
+ * @brief State of one search thread
+ *
+ * Every worker has its own board, node counter, PV table, killers and history.
+ * The only thing workers share is the engine's transposition table, which is
+ * what lets helper threads speed up the main one (Lazy SMP).
+ */
+class SearchWorker {
+public:
+    static constexpr int MAX_PLY = 128;
+    
+    SearchWorker(Engine& engine, int id);
+    
+    // Run iterative deepening on the engine's current root until the search stops
+    void iterate();
+    
+    // Nodes searched by this worker in the current search (can be read from any thread)
+    uint64_t getNodes() const { return nodes.load(std::memory_order_relaxed); }
+    
+    // Negamax alpha-beta with principal variation search, scores are from the side to
+    // move's point of view and ply is the distance from the root
+    int negamax(int depth, int ply, int alpha, int beta);
+    
+    // Search captures and promotions only (every move when in check) until the position
+    // is quiet, so leaf scores aren't taken in the middle of an exchange
+    int quiescence(int ply, int alpha, int beta);
+    
+private:
+    friend class Engine;
+    
+    Engine& engine;
+    int id;                               // 0 is the main thread, which manages time and reports
+    Board board;
+    std::atomic<uint64_t> nodes;
+    int rootDepth;                        // depth of the iteration in progress
+    Evaluator evaluator;
+    
+    // result of the last completed iteration
+    int completedDepth;
+    int bestScore;
+    std::vector<Move> bestLine;
+    
+    // triangular PV table: pvTable[ply] holds the best line found from that ply on
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    
+    // move ordering state: quiet moves that caused a cutoff at each ply, and per move
+    // history scores that carry over between searches
+    Move killers[MAX_PLY][2];
+    HistoryTable history;
+    
+    // Count a node, and on the main thread check the limits every so often
+    void countNode();
+    
+    // Whether the iteration in progress has to be abandoned
+    bool stopping() const;
+    
+    // Static evaluation from the side to move's point of view
+    int evaluate() const {
+        int score = evaluator.evaluate(board);
+        return board.getSideToMove() == Color::WHITE ? score : -score;
+    }
+    
+    // Copy the line below ply + 1 behind move as the PV of ply
+    void updatePV(int ply, Move move);
+    
+    // A quiet move caused a beta cutoff: make it a killer and shift history towards it
+    void updateQuietStats(Color side, Move move, int ply, int depth, const MoveList& quietsTried);
+};
+
 /**
- * @brief A simple chess engine that can look 2 moves into the future
+ * @brief A simple chess engine, searches deeper and deeper until its depth, time or node budget runs out
+ *
+ * With more than one thread, helper threads search the same position at
+ * staggered depths and share results through the transposition table; the
+ * move played is the main thread's.
  */
 class Engine {
 private:
+    friend class SearchWorker;
+    
     int maxDepth;
-    int nodesSearched;
-    Evaluator evaluator;
+    TranspositionTable tt;
     std::chrono::time_point<std::chrono::steady_clock> startTime;
     
+    // the search in progress, read-only for the workers
+    Board root;
+    MoveList rootMoves;
+    SearchLimits limits;
+    int depthLimit;
+    int64_t softTimeLimit;                // time we aim to spend on this move (ms, 0 = none)
+    int64_t hardTimeLimit;                // abort the iteration in progress after this (ms, 0 = none)
+    std::atomic<bool> stopSearch;         // set by stop(), by a limit, or when the main thread is done
+    std::function<void(const SearchInfo&)> infoCallback;
+    
+    // workers[0] runs on the thread calling search(), the others on their own threads, which
+    // sleep between searches
+    std::vector<std::unique_ptr<SearchWorker>> workers;
+    std::vector<std::thread> helperThreads;
+    std::mutex poolMutex;
+    std::condition_variable poolCondition;
+    uint64_t searchGeneration;            // bumped to wake the helpers for a new search
+    int helpersRunning;
+    bool quitting;
+    
+    // search started by startSearch, runs the main worker on its own thread
+    std::thread searchThread;
+    std::atomic<bool> searching;
+    Move asyncBestMove;
+    
+    // Body of search() once the stop flag has been cleared
+    Move runSearch(const Board& board, const SearchLimits& searchLimits);
+    
+    // Work out the time budget for this move from the limits
+    void allocateTime(Color side);
+    
+    // Sets stopSearch once a time or node limit is hit (main thread only)
+    void checkLimits();
+    
+    // Body of a helper thread, waits for searches started after the given generation
+    void helperLoop(int id, uint64_t lastGeneration);
+    
+    // Shut down the helper threads
+    void stopHelpers();
+    
 public:
-    Engine(int depth = 2) : maxDepth(depth), nodesSearched(0) {}
+    static constexpr int MAX_DEPTH = 64;
+    
+    Engine(int depth = 2);
+    ~Engine();
+    
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
     
     // Set the search depth
     void setDepth(int depth) { maxDepth = depth; }
     
-    // Get the best move for the current position
+    // Set the transposition table size in MB (clears it, not during a search)
+    void setHashSize(size_t megabytes) { tt.resize(megabytes); }
+    
+    // Forget all stored search results, e.g. before a new game
+    void clearHash() { tt.clear(); }
+    
+    // Forget the move ordering statistics (history and killers) of every thread, not during a
+    // search. Together with clearHash the next search runs as on a fresh engine
+    void clearHistory();
+    
+    // Set the number of search threads (at least 1, not during a search)
+    void setThreads(int count);
+    
+    // Get the number of search threads
+    int getThreads() const { return static_cast<int>(workers.size()); }
+    
+    // Get the best move for the current position, searching to the configured depth
     Move getBestMove(const Board& board);
     
-    // Minimax algorithm with alpha-beta pruning
-    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer);
+    // Search with iterative deepening until a limit is hit, returns the best move of the
+    // last completed iteration
+    Move search(const Board& board, const SearchLimits& searchLimits);
+    
+    // Same as search() but on a background thread, returns right away. onDone is called from
+    // that thread with the best move when the search ends. A stop() right after this returns
+    // is never lost
+    void startSearch(const Board& board, const SearchLimits& searchLimits,
+                     std::function<void(Move)> onDone = nullptr);
+    
+    // Wait for the search started by startSearch to end, returns its best move
+    Move waitForSearch();
+    
+    // Whether a search started by startSearch is still running
+    bool isSearching() const { return searching; }
+    
+    // Ask a running search to finish as soon as possible (safe to call from another thread)
+    void stop() { stopSearch = true; }
+    
+    // Called with a report after every completed iteration
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback) { infoCallback = std::move(callback); }
+    
+    // Milliseconds since the last search started
+    int64_t getElapsedTime() const;
     
-    // Get the number of nodes searched in the last search
-    int getNodesSearched() const { return nodesSearched; }
+    // Get the number of nodes searched in the last search, over all threads
+    uint64_t getNodesSearched() const;
     
     // Reset the node counter
-    void resetNodesSearched() { nodesSearched = 0; }
+    void resetNodesSearched();
 };
 
 } // namespace chess
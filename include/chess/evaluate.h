@@ -2,41 +2,78 @@
 #define CHESS_EVALUATE_H
 
 #include "chess/board.h"
+#include <vector>
 
 namespace chess {
 
+/**
+ * @brief Squares attacked by each side, worked out once per evaluation and shared by the eval terms
+ *
+ * Mobility and king attack counts are collected while the maps are built,
+ * since they need the same per-piece attack sets.
+ */
+struct AttackInfo {
+    Bitboard byType[3][7];      // [Color][PieceType] squares attacked by that kind of piece
+    Bitboard all[3];            // squares attacked by any piece of a color
+    Bitboard twice[3];          // squares attacked by at least two pieces of a color
+    int mobility[3];            // mobility score of a color's knights, bishops, rooks and queens
+    int kingAttackWeight[3];    // weighted attacks of a color's pieces on squares around the enemy king
+    int kingAttackers[3];       // number of a color's pieces attacking squares around the enemy king
+    
+    // Whether a square is attacked by any piece of a color
+    bool isAttacked(const Position& pos, Color color) const {
+        return all[static_cast<int>(color)] & squareBB(pos.toIndex());
+    }
+};
+
+// Cached pawn structure score of one set of pawns
+struct PawnEntry {
+    uint64_t key = 0;           // Board::pawnHash of the pawns scored
+    int mg = 0;                 // midgame score from white's point of view
+    int eg = 0;                 // endgame score from white's point of view
+};
+
 class Evaluator {
 public:
+    // Pawn hash entries (a power of two)
+    static constexpr size_t PAWN_TABLE_SIZE = 16384;
+    
+    // Evaluation cache entries (a power of two, 8 bytes each)
+    static constexpr size_t EVAL_CACHE_SIZE = 65536;
+    
     // Constructor
-    Evaluator() = default;
+    Evaluator();
     
-    // Main evaluation function
+    // Main evaluation function, answered from the evaluation cache when the position was seen before
     int evaluate(const Board& board) const;
     
 private:
-    // Material evaluation
-    int evaluateMaterial(const Board& board) const;
+    // Run every evaluation term, evaluate() only gets here on a cache miss
+    int evaluateTerms(const Board& board) const;
     
-    // Center control evaluation
-    int evaluateCenterControl(const Board& board) const;
+    // Build the attack maps of both sides
+    void computeAttacks(const Board& board, AttackInfo& attackInfo) const;
     
-    // Piece position evaluation (can be added later)
-    int evaluatePiecePositions(const Board& board) const;
+    // Center control evaluation
+    int evaluateCenterControl(const Board& board, const AttackInfo& attackInfo) const;
     
-    // Mobility evaluation (can be added later)
-    int evaluateMobility(const Board& board) const;
+    // Mobility evaluation, reads the counts collected by computeAttacks
+    int evaluateMobility(const AttackInfo& attackInfo) const;
     
-    // Pawn structure evaluation (can be added later)
+    // Pawn structure evaluation, looked up in the pawn hash before scoring the pawns
     int evaluatePawnStructure(const Board& board) const;
     
-    // King safety evaluation (can be added later)
-    int evaluateKingSafety(const Board& board) const;
+    // Score doubled, isolated, backward, passed and connected pawns into entry
+    void scorePawns(const Board& board, PawnEntry& entry) const;
+    
+    // King safety evaluation, attacks on the squares around each king and its pawn shield
+    int evaluateKingSafety(const Board& board, const AttackInfo& attackInfo) const;
     
     // Discourage early queen development
     int evaluateEarlyQueenDevelopment(const Board& board) const;
     
     // Evaluate piece development in the opening
-    int evaluatePieceDevelopment(const Board& board) const;
+    int evaluatePieceDevelopment(const Board& board, const AttackInfo& attackInfo) const;
     
     // Heavily punish moving the king above the first rank before castling
     int evaluateEarlyKingMovement(const Board& board) const;
@@ -48,7 +85,16 @@ private:
     int evaluateRepeatedMoves(const Board& board) const;
     
     // Discourage moving the same pawn twice in the opening
-    int evaluatePawnDoubleMoves(const Board& board) const;
+    int evaluatePawnDoubleMoves(const Board& board, const AttackInfo& attackInfo) const;
+    
+    // Pawn structure only changes when a pawn moves or is captured, so most positions a search
+    // evaluates share theirs with one already scored (one table per evaluator, so per thread)
+    mutable std::vector<PawnEntry> pawnTable;
+    
+    // Whole evaluations by position key, the same leaves keep coming back through transpositions
+    // and from one iteration to the next. Each entry is the upper 48 bits of the key with the
+    // score (white's point of view) in the low 16 bits
+    mutable std::vector<uint64_t> evalCache;
 };
 
 } // namespace chess
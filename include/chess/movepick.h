@@ -0,0 +1,91 @@
+#ifndef CHESS_MOVEPICK_H
+#define CHESS_MOVEPICK_H
+
+#include "board.h"
+
+namespace chess {
+
+/**
+ * @brief Scores for quiet moves that caused cutoffs before, indexed by side, from and to square
+ *
+ * Updates use a "gravity" formula so scores stay within +-MAX without ever
+ * having to be rescaled, and moves that keep failing drift back down.
+ */
+class HistoryTable {
+public:
+    static constexpr int MAX = 16384;
+    
+    HistoryTable() { clear(); }
+    
+    void clear();
+    
+    int get(Color side, Move move) const {
+        return table[side == Color::BLACK][move.fromSquare()][move.toSquare()];
+    }
+    
+    // Reward (positive bonus) or punish (negative bonus) a quiet move
+    void update(Color side, Move move, int bonus);
+
+private:
+    int table[2][64][64];
+};
+
+/**
+ * @brief Hands out the legal moves of a position one at a time, best guesses first
+ *
+ * Stages: the hash move, captures and promotions by MVV-LVA that don't lose
+ * material by SEE, the two killer moves, the remaining quiets by history score
+ * and finally the losing captures. Each half of the moves is only generated
+ * when its stage is reached, so a cutoff on the hash move or a capture never
+ * pays for generating the quiets.
+ */
+class MovePicker {
+public:
+    MovePicker(const Board& board, Move ttMove, const Move killers[2], const HistoryTable& history);
+    
+    // Captures and promotions only, by MVV-LVA (for quiescence search, which does its own SEE)
+    MovePicker(const Board& board, Move ttMove, const HistoryTable& history);
+    
+    // The next move to search, or a null Move when there are none left
+    Move next();
+
+private:
+    enum Stage {
+        TT_MOVE,
+        INIT_CAPTURES,
+        CAPTURES,
+        KILLERS,
+        QUIETS,
+        BAD_CAPTURES,
+        DONE
+    };
+    
+    const Board& board;
+    const HistoryTable& history;
+    Move ttMove;
+    Move killers[2];
+    int stage;
+    int killerIndex;
+    bool capturesOnly;
+    
+    MoveList captures;
+    MoveList quiets;
+    MoveList badCaptures;
+    int captureScores[MoveList::CAPACITY];
+    int quietScores[MoveList::CAPACITY];
+    int captureIndex;
+    int quietIndex;
+    int badCaptureIndex;
+    bool capturesGenerated;
+    bool quietsGenerated;
+    
+    void generateCaptures();
+    void generateQuiets();
+    
+    // Selection sort step: swap the best scored remaining move to the front and return it
+    static Move pickBest(MoveList& moves, int* scores, int& index);
+};
+
+} // namespace chess
+
+#endif // CHESS_MOVEPICK_H
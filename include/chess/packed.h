@@ -0,0 +1,107 @@
+#ifndef CHESS_PACKED_H
+#define CHESS_PACKED_H
+
+#include "board.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace chess {
+
+// A position in 32 bytes, for storing datasets of positions compactly. Multi-byte fields are
+// little endian, so files can move between machines:
+//   bytes  0-7   occupied squares (bit n is square n, a1 = 0)
+//   bytes  8-23  the piece on each occupied square from a1 up, a nibble each (low nibble first):
+//                the PieceType in the low 3 bits, the top bit set for black
+//   byte  24     side to move (0 white, 1 black)
+//   byte  25     castling rights (CastlingRight bits)
+//   byte  26     en passant target square, 64 if there is none
+//   byte  27     half move clock (255 at most)
+//   bytes 28-29  full move number (65535 at most)
+//   bytes 30-31  zero
+struct PackedPosition {
+    uint8_t bytes[32];
+};
+
+static_assert(sizeof(PackedPosition) == 32, "packed positions are stored as 32-byte records");
+
+/**
+ * @brief Writes packed positions to a file
+ *
+ * The file is nothing but the 32-byte records one after another, so besides PackedReader
+ * numpy.fromfile(path, dtype=numpy.uint8).reshape(-1, 32) reads it too.
+ */
+class PackedWriter {
+private:
+    std::FILE* file;
+    std::vector<PackedPosition> buffer;   // written out when full, on flush and when closing
+    size_t buffered;
+    uint64_t written;
+    bool failed;
+
+public:
+    // Create (or truncate) the file at path, check isOpen before use
+    explicit PackedWriter(const std::string& path);
+    
+    // Flushes what's still buffered and closes the file
+    ~PackedWriter();
+    
+    PackedWriter(const PackedWriter&) = delete;
+    PackedWriter& operator=(const PackedWriter&) = delete;
+    
+    bool isOpen() const { return file != nullptr; }
+    
+    // Append a position, false if it can't be packed or writing failed
+    bool write(const Board& board);
+    bool write(const PackedPosition& packed);
+    
+    // Write out the buffered positions, false if writing failed (now or before)
+    bool flush();
+    
+    // Number of positions written so far, buffered ones included
+    uint64_t count() const { return written; }
+};
+
+/**
+ * @brief Reads the positions of a file written by PackedWriter, in blocks
+ */
+class PackedReader {
+private:
+    std::FILE* file;
+    std::vector<PackedPosition> buffer;
+    size_t filled;                        // records in the buffer
+    size_t next;                          // next record to hand out
+    uint64_t readCount;
+    bool failed;
+    
+    // Read the next block, false at the end of the file
+    bool refill();
+
+public:
+    // Open the file at path, check isOpen before use
+    explicit PackedReader(const std::string& path);
+    ~PackedReader();
+    
+    PackedReader(const PackedReader&) = delete;
+    PackedReader& operator=(const PackedReader&) = delete;
+    
+    bool isOpen() const { return file != nullptr; }
+    
+    // Read the next position, false at the end of the file
+    bool read(PackedPosition& packed);
+    
+    // Set up board with the next position, false at the end of the file or on a malformed one
+    bool read(Board& board);
+    
+    // Whether reading stopped on a malformed position, a read error or a truncated last record
+    // rather than at the end of the file
+    bool hasFailed() const { return failed; }
+    
+    // Number of positions read so far
+    uint64_t count() const { return readCount; }
+};
+
+} // namespace chess
+
+#endif // CHESS_PACKED_H
@@ -1,6 +1,7 @@
 #ifndef CHESS_PIECE_H
 #define CHESS_PIECE_H
 
+#include <cstdint>
 #include <string>
 
 namespace chess {
@@ -21,22 +22,31 @@ enum class Color {
     BLACK
 };
 
+// The other side
+inline Color opposite(Color color) {
+    return (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+}
+
 /**
  * @brief Represents a chess piece
  */
 class Piece {
 private:
-    PieceType type;
-    Color color;
+    // type in the low 3 bits, color above it, so a piece fits in one byte
+    uint8_t code;
 
 public:
-    Piece() : type(PieceType::EMPTY), color(Color::NONE) {}
-    Piece(PieceType type, Color color) : type(type), color(color) {}
+    Piece() : code(0) {}
+    Piece(PieceType type, Color color)
+        : code(static_cast<uint8_t>(static_cast<int>(type) | (static_cast<int>(color) << 3))) {}
 
-    PieceType getType() const { return type; }
-    Color getColor() const { return color; }
+    PieceType getType() const { return static_cast<PieceType>(code & 7); }
+    Color getColor() const { return static_cast<Color>(code >> 3); }
+    
+    bool isEmpty() const { return getType() == PieceType::EMPTY; }
     
-    bool isEmpty() const { return type == PieceType::EMPTY; }
+    bool operator==(const Piece& other) const { return code == other.code; }
+    bool operator!=(const Piece& other) const { return code != other.code; }
     
     // Get the character representation of the piece
     char toChar() const;
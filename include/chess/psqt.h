@@ -0,0 +1,45 @@
+#ifndef CHESS_PSQT_H
+#define CHESS_PSQT_H
+
+#include "piece.h"
+
+namespace chess {
+
+/**
+ * @brief Material and piece-square values, separately for the midgame and the endgame
+ *
+ * Each entry already includes the piece's material value and is negated for
+ * black, so the board can keep one running white-minus-black sum per phase
+ * and the evaluation only has to blend the two by the material left.
+ */
+namespace psqt {
+
+// Midgame and endgame halves of a score
+struct Score {
+    int mg;
+    int eg;
+};
+
+constexpr int MAX_PHASE = 24;           // phase with all minor and major pieces on the board
+
+extern Score table[3][7][64];           // [Color][PieceType][square], zero for empty squares
+extern int phaseWeight[7];              // how much each PieceType counts towards the phase
+
+// Build the tables (done automatically before main, calling it again is harmless)
+void init();
+
+inline const Score& pieceScore(const Piece& piece, int square) {
+    return table[static_cast<int>(piece.getColor())][static_cast<int>(piece.getType())][square];
+}
+
+// Blend a midgame and endgame score by phase (MAX_PHASE is all midgame, 0 all endgame)
+inline int taper(int mg, int eg, int phase) {
+    if (phase > MAX_PHASE) phase = MAX_PHASE;
+    return (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE;
+}
+
+} // namespace psqt
+
+} // namespace chess
+
+#endif // CHESS_PSQT_H
@@ -0,0 +1,86 @@
+#ifndef CHESS_TRANSPOSITION_H
+#define CHESS_TRANSPOSITION_H
+
+#include "board.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace chess {
+
+// What a stored score says about the real value of the position
+enum class Bound : uint8_t {
+    NONE = 0,
+    UPPER = 1,      // failed low, the real score is at most this
+    LOWER = 2,      // failed high, the real score is at least this
+    EXACT = 3
+};
+
+// A decoded transposition table entry
+struct TTEntry {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+/**
+ * @brief Fixed-size hash table of search results shared by all search threads
+ *
+ * Entries are grouped in 64-byte buckets (one cache line) of four slots, so a
+ * probe touches a single line. There is no locking: each slot stores the
+ * packed data plus the position key XORed with that data. A slot torn by two
+ * threads writing at once no longer verifies and is simply treated as a miss.
+ */
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+    
+    // Reallocate to the given size in MB (clears the table, not thread safe)
+    void resize(size_t megabytes);
+    
+    // Forget everything stored
+    void clear();
+    
+    // Mark the start of a new search so entries from older ones get replaced first
+    void newSearch() { age = (age + 1) & AGE_MASK; }
+    
+    // Look up a position, returns false if it isn't stored
+    bool probe(uint64_t key, TTEntry& entry) const;
+    
+    // Store a search result (a null move keeps the best move already stored for the position).
+    // A shallower non-exact result for a position stored deeper by this search is dropped
+    void store(uint64_t key, Move move, int score, int depth, Bound bound);
+    
+    // Permille of sampled slots used by the current search (what UCI calls hashfull)
+    int hashfull() const;
+    
+    // Size of the table in MB
+    size_t getSizeMB() const { return bucketCount * sizeof(Bucket) / (1024 * 1024); }
+
+private:
+    static constexpr unsigned AGE_MASK = 0x3F;
+    
+    struct Slot {
+        std::atomic<uint64_t> key{0};   // position key ^ data
+        std::atomic<uint64_t> data{0};  // packed move, score, depth, bound and age
+    };
+    
+    struct alignas(64) Bucket {
+        Slot slots[4];
+    };
+    
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount;
+    unsigned age;
+    
+    Bucket& bucketFor(uint64_t key) const {
+        // multiply-shift maps the key onto any bucket count, not just powers of two
+        return buckets[static_cast<size_t>((static_cast<unsigned __int128>(key) * bucketCount) >> 64)];
+    }
+};
+
+} // namespace chess
+
+#endif // CHESS_TRANSPOSITION_H
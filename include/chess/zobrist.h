@@ -0,0 +1,34 @@
+#ifndef CHESS_ZOBRIST_H
+#define CHESS_ZOBRIST_H
+
+#include "piece.h"
+#include <cstdint>
+
+namespace chess {
+
+/**
+ * @brief Random keys for Zobrist hashing
+ *
+ * A position's hash is the XOR of the keys of everything in it, so making a
+ * move only needs to XOR out what changed. The keys are generated once at
+ * program startup from a fixed seed, so hashes are stable between runs.
+ */
+namespace zobrist {
+
+extern uint64_t pieceKeys[3][7][64];    // [Color][PieceType][square]
+extern uint64_t sideKey;                // XORed in when black is to move
+extern uint64_t castlingKeys[16];       // one per combination of CastlingRight bits
+extern uint64_t enPassantKeys[8];       // one per en passant file
+
+// Build the keys (done automatically before main, calling it again is harmless)
+void init();
+
+inline uint64_t pieceKey(const Piece& piece, int square) {
+    return pieceKeys[static_cast<int>(piece.getColor())][static_cast<int>(piece.getType())][square];
+}
+
+} // namespace zobrist
+
+} // namespace chess
+
+#endif // CHESS_ZOBRIST_H
@@ -0,0 +1,187 @@
+// BrothFish UCI front end: reads commands from stdin and answers on stdout, so the engine
+// can be used from any UCI GUI or tournament manager
+//
+// supported: uci, isready, ucinewgame, setoption (Hash, Threads), position, go, stop, quit
+
+#include "chess/board.h"
+#include "chess/engine.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int DEFAULT_HASH_MB = 16;
+const int MAX_HASH_MB = 65536;
+const int MAX_THREADS = 256;
+
+// the search thread prints info and bestmove while this one answers isready, keep lines whole
+std::mutex outputMutex;
+
+void send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+// UCI wants "0000" for no move
+std::string moveToUCI(const chess::Move& move) {
+    return move.isNull() ? "0000" : move.toAlgebraic();
+}
+
+void sendInfo(const chess::SearchInfo& info) {
+    std::ostringstream line;
+    line << "info depth " << info.depth;
+    if (info.mate != 0) {
+        line << " score mate " << info.mate;
+    } else {
+        line << " score cp " << info.score;
+    }
+    
+    uint64_t nps = info.time > 0 ? info.nodes * 1000 / info.time : info.nodes;
+    line << " nodes " << info.nodes << " nps " << nps << " time " << info.time
+         << " hashfull " << info.hashfull;
+    
+    if (!info.pv.empty()) {
+        line << " pv";
+        for (const chess::Move& move : info.pv) {
+            line << " " << move.toAlgebraic();
+        }
+    }
+    
+    send(line.str());
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void handlePosition(std::istringstream& args, chess::Board& board) {
+    std::string token;
+    args >> token;
+    
+    if (token == "startpos") {
+        board = chess::Board(START_FEN);
+        args >> token;
+    } else if (token == "fen") {
+        std::string fen;
+        while (args >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+        if (!board.loadFEN(fen)) {
+            send("info string invalid fen " + fen);
+            board = chess::Board(START_FEN);
+            return;
+        }
+    } else {
+        return;
+    }
+    
+    // token is "moves" now if there are any
+    while (args >> token) {
+        if (!board.makeMove(chess::Move::fromAlgebraic(token))) {
+            send("info string illegal move " + token);
+            break;
+        }
+    }
+}
+
+// go [depth N] [movetime N] [wtime N] [btime N] [winc N] [binc N] [movestogo N] [nodes N] [infinite]
+chess::SearchLimits parseGo(std::istringstream& args) {
+    chess::SearchLimits limits;
+    std::string token;
+    
+    while (args >> token) {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "movetime") args >> limits.movetime;
+        else if (token == "wtime") args >> limits.wtime;
+        else if (token == "btime") args >> limits.btime;
+        else if (token == "winc") args >> limits.winc;
+        else if (token == "binc") args >> limits.binc;
+        else if (token == "movestogo") args >> limits.movestogo;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "infinite") limits.infinite = true;
+    }
+    
+    return limits;
+}
+
+// setoption name <name> [value <value>]
+void handleSetOption(std::istringstream& args, chess::Engine& engine) {
+    std::string token, name, value;
+    args >> token; // "name"
+    
+    while (args >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    std::getline(args >> std::ws, value);
+    
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    
+    if (name == "hash") {
+        int megabytes = std::max(1, std::min(std::atoi(value.c_str()), MAX_HASH_MB));
+        engine.setHashSize(megabytes);
+    } else if (name == "threads") {
+        int threads = std::max(1, std::min(std::atoi(value.c_str()), MAX_THREADS));
+        engine.setThreads(threads);
+    } else {
+        send("info string unknown option " + name);
+    }
+}
+
+} // namespace
+
+int main() {
+    chess::Engine engine;
+    chess::Board board(START_FEN);
+    
+    engine.setHashSize(DEFAULT_HASH_MB);
+    engine.setInfoCallback(sendInfo);
+    
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+        
+        if (command == "uci") {
+            send("id name BrothFish");
+            send("id author AdrianGev");
+            send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) +
+                 " min 1 max " + std::to_string(MAX_HASH_MB));
+            send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "ucinewgame") {
+            engine.stop();
+            engine.waitForSearch();
+            engine.clearHash();
+            board = chess::Board(START_FEN);
+        } else if (command == "setoption") {
+            engine.stop();
+            engine.waitForSearch();
+            handleSetOption(args, engine);
+        } else if (command == "position") {
+            engine.stop();
+            engine.waitForSearch();
+            handlePosition(args, board);
+        } else if (command == "go") {
+            engine.stop();
+            engine.waitForSearch();
+            engine.startSearch(board, parseGo(args), [](chess::Move best) {
+                send("bestmove " + moveToUCI(best));
+            });
+        } else if (command == "stop") {
+            engine.stop();
+            engine.waitForSearch();
+        } else if (command == "quit") {
+            break;
+        }
+    }
+    
+    // the engine's destructor stops and waits for a search still running
+    return 0;
+}
@@ -1,12 +1,21 @@
 from chess_piece import Piece, PieceType, Color
 from chess_position import Position, Move
 
+# use the C++ move generator when the engine module is built (complete rules and much faster)
+try:
+    import chess_engine
+except ImportError:
+    chess_engine = None
+
 class MoveGenerator:
     def __init__(self, board):
         self.board = board
     
     def generate_legal_moves(self):
         # generate all legal moves for the current side to move
+        if chess_engine is not None:
+            return [Move.from_algebraic(m) for m in chess_engine.get_legal_moves(self.board.to_fen())]
+        
         pseudo_legal_moves = self.generate_pseudo_legal_moves()
         legal_moves = []
         
@@ -326,6 +335,9 @@ class MoveGenerator:
         if color is None:
             color = self.board.get_side_to_move()
         
+        if chess_engine is not None and color == self.board.get_side_to_move():
+            return chess_engine.is_in_check(self.board.to_fen())
+        
         # find the king
         king_pos = None
         for rank in range(8):
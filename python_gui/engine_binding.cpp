@@ -1,11 +1,287 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include "../include/chess/engine.h"
 #include "../include/chess/board.h"
 #include "../include/chess/evaluate.h"
+#include "../include/chess/packed.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
 
 namespace py = pybind11;
 
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// run worker(next) on a pool of threads (all cores when threads <= 0). Each worker takes its own
+// per-thread state, then claims indices below count from next one at a time, so a slow position
+// doesn't hold up a whole chunk
+template <typename Worker>
+void runPool(size_t count, int threads, Worker worker) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = static_cast<int>(std::min<size_t>(threads, std::max<size_t>(count, 1)));
+    
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++) {
+        pool.emplace_back([&] { worker(next); });
+    }
+    worker(next);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+// index of the first FEN that failed to parse, or -1
+long firstFailure(const std::vector<char>& failed) {
+    auto it = std::find(failed.begin(), failed.end(), 1);
+    return it == failed.end() ? -1 : static_cast<long>(it - failed.begin());
+}
+
+} // namespace
+
+// an engine that lives across moves: the hash table, move ordering history and the game so far
+// are kept between searches instead of starting cold every time.
+//
+// searches run without the GIL. start_search runs one in the background while Python carries on,
+// the board can still be changed meanwhile since the search works on its own copy.
+//
+// locking: board, moves and threadCount are only touched with the GIL held, the engine only with
+// controlMutex held and the GIL released. The two are never held at once, a search keeps
+// controlMutex for as long as it runs and must not stall every other Python thread meanwhile.
+// The exceptions are stop() and is_searching(), which only use the engine's atomic flags and
+// have to work while another thread is searching
+class EngineSession {
+private:
+    chess::Engine engine;
+    chess::Board board;
+    std::vector<std::string> moves;     // moves played since the last set_position, as given
+    int depth;
+    int threadCount;                    // the engine's thread count, readable without the lock
+    chess::Evaluator evaluator;         // for evaluate(), its caches are too big to set up per call
+    
+    // written by the search thread, read from Python
+    std::mutex infoMutex;
+    chess::SearchInfo lastInfo;                 // report of the last completed iteration
+    std::vector<chess::SearchInfo> pendingInfo; // reports poll() hasn't returned yet
+    
+    // serialises everything that uses or changes the engine, which can come from several
+    // Python threads once the GIL is released
+    std::mutex controlMutex;
+    bool asyncPending;                  // start_search ran and result() hasn't collected it yet
+    
+    chess::SearchLimits makeLimits(int searchDepth, int64_t movetime, uint64_t nodes, bool infinite) const {
+        chess::SearchLimits limits;
+        limits.depth = searchDepth;
+        limits.movetime = movetime;
+        limits.nodes = nodes;
+        limits.infinite = infinite;
+        if (searchDepth <= 0 && movetime <= 0 && nodes == 0 && !infinite) {
+            limits.depth = depth;
+        }
+        return limits;
+    }
+    
+    void resetInfo() {
+        std::lock_guard<std::mutex> lock(infoMutex);
+        lastInfo = chess::SearchInfo();
+        pendingInfo.clear();
+    }
+    
+    // end a background search before touching the engine. The engine stays locked until the
+    // returned lock goes away, so no other thread can start a search in between
+    std::unique_lock<std::mutex> finishSearch() {
+        std::unique_lock<std::mutex> lock(controlMutex);
+        engine.stop();
+        engine.waitForSearch();
+        asyncPending = false;
+        return lock;
+    }
+    
+public:
+    EngineSession(int depth, size_t hashMB, int threads)
+        : engine(depth), board(START_FEN), depth(depth), lastInfo(), asyncPending(false) {
+        engine.setHashSize(hashMB);
+        engine.setThreads(threads);
+        threadCount = engine.getThreads();
+        engine.setInfoCallback([this](const chess::SearchInfo& info) {
+            std::lock_guard<std::mutex> lock(infoMutex);
+            lastInfo = info;
+            pendingInfo.push_back(info);
+        });
+    }
+    
+    // the search thread reports into this object, so it has to be gone before the members are.
+    // this runs with the GIL held, but by now no other thread can be inside a method
+    ~EngineSession() {
+        finishSearch();
+    }
+    
+    // forget everything learned, for a new game (stops a background search)
+    void new_game(const std::string& fen) {
+        chess::Board start(fen);
+        {
+            py::gil_scoped_release release;
+            auto lock = finishSearch();
+            engine.clearHash();
+        }
+        board = start;
+        moves.clear();
+    }
+    
+    // set up a position, the hash table is kept so it still helps if the game continues from here.
+    // Returns false and changes nothing if one of the moves is illegal
+    bool set_position(const std::string& fen, const std::vector<std::string>& moveList) {
+        chess::Board position(fen);
+        for (const std::string& move : moveList) {
+            if (!position.makeMove(chess::Move::fromAlgebraic(move))) {
+                return false;
+            }
+        }
+        
+        board = position;
+        moves = moveList;
+        return true;
+    }
+    
+    // play a move in algebraic notation, returns false (and changes nothing) if it's illegal
+    bool push_move(const std::string& move) {
+        if (!board.makeMove(chess::Move::fromAlgebraic(move))) {
+            return false;
+        }
+        moves.push_back(move);
+        return true;
+    }
+    
+    // take back the last move played through push_move
+    bool pop_move() {
+        if (moves.empty()) {
+            return false;
+        }
+        board.unmakeMove();
+        moves.pop_back();
+        return true;
+    }
+    
+    // search the current position and wait for the result, with no limits given the session's
+    // depth is used (stops a background search first)
+    std::string search(int searchDepth, int64_t movetime, uint64_t nodes) {
+        chess::Board position = board;
+        chess::SearchLimits limits = makeLimits(searchDepth, movetime, nodes, false);
+        
+        py::gil_scoped_release release;
+        auto lock = finishSearch();
+        resetInfo();
+        chess::Move best = engine.search(position, limits);
+        return best.isNull() ? "" : best.toAlgebraic();
+    }
+    
+    // start searching the current position in the background and return right away
+    void start_search(int searchDepth, int64_t movetime, uint64_t nodes, bool infinite) {
+        chess::Board position = board;
+        chess::SearchLimits limits = makeLimits(searchDepth, movetime, nodes, infinite);
+        
+        py::gil_scoped_release release;
+        auto lock = finishSearch();
+        resetInfo();
+        engine.startSearch(position, limits);
+        asyncPending = true;
+    }
+    
+    // reports of the iterations completed since the last poll
+    std::vector<chess::SearchInfo> poll() {
+        std::lock_guard<std::mutex> lock(infoMutex);
+        std::vector<chess::SearchInfo> reports;
+        reports.swap(pendingInfo);
+        return reports;
+    }
+    
+    // ask a background search to finish, result() then returns quickly
+    void stop() { engine.stop(); }
+    
+    bool is_searching() const { return engine.isSearching(); }
+    
+    // wait up to timeout seconds (forever if negative) for the background search, true once it's done
+    bool wait(double timeout) {
+        auto start = std::chrono::steady_clock::now();
+        while (engine.isSearching()) {
+            if (timeout >= 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= timeout) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+    
+    // best move of the background search, waiting for it to finish ('' if there is no move, or no
+    // search started by start_search left to collect)
+    std::string result() {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (!asyncPending) {
+            return "";
+        }
+        asyncPending = false;
+        chess::Move best = engine.waitForSearch();
+        return best.isNull() ? "" : best.toAlgebraic();
+    }
+    
+    // static evaluation of the current position, from white's point of view
+    int evaluate() const {
+        return evaluator.evaluate(board);
+    }
+    
+    std::string fen() const { return board.toFEN(); }
+    const std::vector<std::string>& get_moves() const { return moves; }
+    std::vector<std::string> legal_moves() const {
+        std::vector<std::string> result;
+        for (const chess::Move& move : board.generateLegalMoves()) {
+            result.push_back(move.toAlgebraic());
+        }
+        return result;
+    }
+    bool in_check() const { return board.isInCheck(); }
+    bool is_draw() const { return board.isDraw(); }
+    
+    uint64_t nodes_searched() {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(controlMutex);
+        return engine.getNodesSearched();
+    }
+    chess::SearchInfo last_info() {
+        std::lock_guard<std::mutex> lock(infoMutex);
+        return lastInfo;
+    }
+    
+    int get_depth() const { return depth; }
+    void set_depth(int newDepth) {
+        depth = newDepth;
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(controlMutex);
+        engine.setDepth(newDepth);
+    }
+    
+    // these reallocate engine state, so a background search is stopped first
+    void set_hash_size(size_t megabytes) {
+        py::gil_scoped_release release;
+        auto lock = finishSearch();
+        engine.setHashSize(megabytes);
+    }
+    void set_threads(int threads) {
+        threadCount = std::max(threads, 1);
+        py::gil_scoped_release release;
+        auto lock = finishSearch();
+        engine.setThreads(threads);
+    }
+    int get_threads() const { return threadCount; }
+};
+
 // wrapper function to get the best move as an algebraic string
 std::string get_engine_move(const std::string& fen, int depth) {
     chess::Board board(fen);
@@ -17,20 +293,333 @@ std::string get_engine_move(const std::string& fen, int depth) {
 // wrapper function to get the evaluation of a position
 int evaluate_position(const std::string& fen) {
     chess::Board board(fen);
-    chess::Evaluator evaluator;
+    // one evaluator per thread for good, allocating its caches costs far more than evaluating
+    thread_local chess::Evaluator evaluator;
     return evaluator.evaluate(board);
 }
 
+// wrapper function to list the legal moves of a position in algebraic notation
+std::vector<std::string> get_legal_moves(const std::string& fen) {
+    chess::Board board(fen);
+    std::vector<std::string> moves;
+    for (const chess::Move& move : board.generateLegalMoves()) {
+        moves.push_back(move.toAlgebraic());
+    }
+    return moves;
+}
+
+// wrapper function to check if the side to move is in check
+bool is_in_check(const std::string& fen) {
+    chess::Board board(fen);
+    return board.isInCheck();
+}
+
+// wrapper function to play a move, returns the new FEN (empty if the move is illegal)
+std::string make_move(const std::string& fen, const std::string& move) {
+    chess::Board board(fen);
+    if (!board.makeMove(chess::Move::fromAlgebraic(move))) {
+        return "";
+    }
+    return board.toFEN();
+}
+
+// wrapper function to check for a draw by the fifty move rule or insufficient material
+bool is_draw(const std::string& fen) {
+    chess::Board board(fen);
+    return board.isDraw();
+}
+
+// evaluate many positions at once, returns the static evaluations (white's point of view) as an
+// int32 NumPy array in input order
+py::array_t<int32_t> evaluate_batch(const std::vector<std::string>& fens, int threads) {
+    std::vector<int32_t> scores(fens.size());
+    std::vector<char> failed(fens.size(), 0);
+    
+    {
+        py::gil_scoped_release release;
+        runPool(fens.size(), threads, [&](std::atomic<size_t>& next) {
+            // one evaluator and board per thread, the caches stay warm and loading a position
+            // doesn't allocate
+            chess::Evaluator evaluator;
+            chess::Board board;
+            for (size_t i; (i = next++) < fens.size();) {
+                if (board.loadFEN(fens[i])) {
+                    scores[i] = evaluator.evaluate(board);
+                } else {
+                    failed[i] = 1;
+                }
+            }
+        });
+    }
+    
+    long bad = firstFailure(failed);
+    if (bad >= 0) {
+        throw py::value_error("invalid FEN at index " + std::to_string(bad) + ": " + fens[bad]);
+    }
+    
+    py::array_t<int32_t> result(static_cast<py::ssize_t>(scores.size()));
+    std::copy(scores.begin(), scores.end(), result.mutable_data());
+    return result;
+}
+
+// search many positions at once to a fixed depth (or node budget), returns (moves, scores):
+// moves as a NumPy bytes array (dtype S5, b'' when there is no legal move) and scores as int32
+// from the side to move's point of view
+py::tuple search_batch(const std::vector<std::string>& fens, int depth, uint64_t nodes, int threads, size_t hashMB) {
+    const size_t MOVE_CHARS = 5;
+    std::vector<char> moves(fens.size() * MOVE_CHARS, 0);
+    std::vector<int32_t> scores(fens.size(), 0);
+    std::vector<char> failed(fens.size(), 0);
+    
+    chess::SearchLimits limits;
+    limits.depth = depth;
+    limits.nodes = nodes;
+    if (depth <= 0 && nodes == 0) {
+        limits.depth = 3;
+    }
+    
+    {
+        py::gil_scoped_release release;
+        runPool(fens.size(), threads, [&](std::atomic<size_t>& next) {
+            // one engine per thread, building one allocates its hash table and caches which
+            // costs about as much as a shallow search
+            chess::Engine engine;
+            engine.setHashSize(hashMB);
+            int score = 0;
+            engine.setInfoCallback([&](const chess::SearchInfo& info) { score = info.score; });
+            
+            chess::Board board;
+            for (size_t i; (i = next++) < fens.size();) {
+                if (!board.loadFEN(fens[i])) {
+                    failed[i] = 1;
+                    continue;
+                }
+                
+                // start every position from a clean table and history, so results don't depend
+                // on which thread got which positions before
+                engine.clearHash();
+                engine.clearHistory();
+                score = 0;
+                
+                chess::Move best = engine.search(board, limits);
+                if (!best.isNull()) {
+                    std::string text = best.toAlgebraic();
+                    std::memcpy(&moves[i * MOVE_CHARS], text.data(), std::min(text.size(), MOVE_CHARS));
+                }
+                scores[i] = score;
+            }
+        });
+    }
+    
+    long bad = firstFailure(failed);
+    if (bad >= 0) {
+        throw py::value_error("invalid FEN at index " + std::to_string(bad) + ": " + fens[bad]);
+    }
+    
+    py::array moveArray(py::dtype("S5"), std::vector<py::ssize_t>{static_cast<py::ssize_t>(fens.size())});
+    if (!moves.empty()) {
+        std::memcpy(moveArray.mutable_data(), moves.data(), moves.size());
+    }
+    py::array_t<int32_t> scoreArray(static_cast<py::ssize_t>(scores.size()));
+    std::copy(scores.begin(), scores.end(), scoreArray.mutable_data());
+    
+    return py::make_tuple(moveArray, scoreArray);
+}
+
+// a NumPy array of packed positions as the binding takes them: uint8, one 32-byte row each
+using PackedArray = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>;
+
+const chess::PackedPosition* packedRows(const PackedArray& packed) {
+    if (packed.ndim() != 2 || packed.shape(1) != static_cast<py::ssize_t>(sizeof(chess::PackedPosition))) {
+        throw py::value_error("packed positions must be a uint8 array of shape (n, 32)");
+    }
+    return reinterpret_cast<const chess::PackedPosition*>(packed.data());
+}
+
+// pack FENs into 32-byte positions (see chess/packed.h), returns a uint8 NumPy array of shape
+// (n, 32). array.tofile(path) stores it in the format PackedWriter writes
+PackedArray pack_positions(const std::vector<std::string>& fens) {
+    PackedArray result(std::vector<py::ssize_t>{static_cast<py::ssize_t>(fens.size()),
+                                                static_cast<py::ssize_t>(sizeof(chess::PackedPosition))});
+    chess::PackedPosition* rows = reinterpret_cast<chess::PackedPosition*>(result.mutable_data());
+    
+    chess::Board board;
+    for (size_t i = 0; i < fens.size(); i++) {
+        if (!board.loadFEN(fens[i]) || !board.writePacked(rows[i])) {
+            throw py::value_error("can't pack the FEN at index " + std::to_string(i) + ": " + fens[i]);
+        }
+    }
+    return result;
+}
+
+// the FENs of packed positions
+std::vector<std::string> unpack_positions(const PackedArray& packed) {
+    const chess::PackedPosition* rows = packedRows(packed);
+    std::vector<std::string> fens(static_cast<size_t>(packed.shape(0)));
+    
+    chess::Board board;
+    char fen[chess::Board::MAX_FEN_LENGTH];
+    for (size_t i = 0; i < fens.size(); i++) {
+        if (!board.loadPacked(rows[i])) {
+            throw py::value_error("malformed packed position at index " + std::to_string(i));
+        }
+        fens[i].assign(fen, board.writeFEN(fen));
+    }
+    return fens;
+}
+
+// evaluate_batch for packed positions, skips parsing FENs altogether
+py::array_t<int32_t> evaluate_packed(const PackedArray& packed, int threads) {
+    const chess::PackedPosition* rows = packedRows(packed);
+    size_t count = static_cast<size_t>(packed.shape(0));
+    std::vector<int32_t> scores(count);
+    std::vector<char> failed(count, 0);
+    
+    {
+        py::gil_scoped_release release;
+        runPool(count, threads, [&](std::atomic<size_t>& next) {
+            chess::Evaluator evaluator;
+            chess::Board board;
+            for (size_t i; (i = next++) < count;) {
+                if (board.loadPacked(rows[i])) {
+                    scores[i] = evaluator.evaluate(board);
+                } else {
+                    failed[i] = 1;
+                }
+            }
+        });
+    }
+    
+    long bad = firstFailure(failed);
+    if (bad >= 0) {
+        throw py::value_error("malformed packed position at index " + std::to_string(bad));
+    }
+    
+    py::array_t<int32_t> result(static_cast<py::ssize_t>(scores.size()));
+    std::copy(scores.begin(), scores.end(), result.mutable_data());
+    return result;
+}
+
 PYBIND11_MODULE(chess_engine, m) {
     m.doc() = "BrothFish chess engine C++ binding - simplified version";
     
-    // wrapper function to get the best move as a string
+    // wrapper function to get the best move as a string (other Python threads keep running meanwhile)
     m.def("get_best_move", &get_engine_move, 
           "get the best move for a position in FEN notation",
-          py::arg("fen"), py::arg("depth") = 3);
+          py::arg("fen"), py::arg("depth") = 3,
+          py::call_guard<py::gil_scoped_release>());
     
     // wrapper function to evaluate a position
     m.def("evaluate_position", &evaluate_position,
           "evaluate a position in FEN notation",
           py::arg("fen"));
+    
+    // move generation and rules, so the GUI doesn't need its own move generator
+    m.def("get_legal_moves", &get_legal_moves,
+          "get the legal moves for a position in FEN notation",
+          py::arg("fen"));
+    
+    m.def("is_in_check", &is_in_check,
+          "check if the side to move is in check",
+          py::arg("fen"));
+    
+    m.def("make_move", &make_move,
+          "play a move in algebraic notation, returns the new FEN or an empty string if illegal",
+          py::arg("fen"), py::arg("move"));
+    
+    m.def("is_draw", &is_draw,
+          "check for a draw by the fifty move rule or insufficient material",
+          py::arg("fen"));
+    
+    // batch entry points for datasets, the work is spread over a pool of C++ threads
+    m.def("evaluate_batch", &evaluate_batch,
+          "evaluate a list of FENs, returns an int32 NumPy array of scores from white's point of view",
+          py::arg("fens"), py::arg("threads") = 0);
+    
+    m.def("search_batch", &search_batch,
+          "search a list of FENs, returns (moves, scores): an S5 NumPy array of moves and an int32 "
+          "array of scores from the side to move's point of view",
+          py::arg("fens"), py::arg("depth") = 3, py::arg("nodes") = 0, py::arg("threads") = 0,
+          py::arg("hash_mb") = 1);
+    
+    // packed 32-byte positions, read a file of them with numpy.fromfile(path, numpy.uint8).reshape(-1, 32)
+    m.def("pack_positions", &pack_positions,
+          "pack a list of FENs into a uint8 NumPy array of shape (n, 32)",
+          py::arg("fens"));
+    
+    m.def("unpack_positions", &unpack_positions,
+          "the FENs of a uint8 array of packed positions",
+          py::arg("packed"));
+    
+    m.def("evaluate_packed", &evaluate_packed,
+          "evaluate_batch for a uint8 array of packed positions",
+          py::arg("packed"), py::arg("threads") = 0);
+    
+    // progress report of a search
+    py::class_<chess::SearchInfo>(m, "SearchInfo")
+        .def_readonly("depth", &chess::SearchInfo::depth)
+        .def_readonly("score", &chess::SearchInfo::score, "centipawns from the side to move's point of view")
+        .def_readonly("mate", &chess::SearchInfo::mate, "moves until mate (negative when getting mated), 0 if none")
+        .def_readonly("nodes", &chess::SearchInfo::nodes)
+        .def_readonly("time", &chess::SearchInfo::time, "milliseconds since the search started")
+        .def_readonly("hashfull", &chess::SearchInfo::hashfull, "permille of the hash table used")
+        .def_property_readonly("best_move", [](const chess::SearchInfo& info) {
+            return info.bestMove.isNull() ? std::string() : info.bestMove.toAlgebraic();
+        })
+        .def_property_readonly("pv", [](const chess::SearchInfo& info) {
+            std::vector<std::string> pv;
+            for (const chess::Move& move : info.pv) {
+                pv.push_back(move.toAlgebraic());
+            }
+            return pv;
+        });
+    
+    // an engine that keeps its hash table, history and the game between moves
+    py::class_<EngineSession>(m, "Engine")
+        .def(py::init<int, size_t, int>(),
+             py::arg("depth") = 3, py::arg("hash_mb") = 16, py::arg("threads") = 1)
+        .def("new_game", &EngineSession::new_game,
+             "clear the hash table and start from a position",
+             py::arg("fen") = START_FEN)
+        .def("set_position", &EngineSession::set_position,
+             "set up a position from FEN plus moves played from it, returns False (changing nothing) on an illegal move",
+             py::arg("fen") = START_FEN, py::arg("moves") = std::vector<std::string>())
+        .def("push_move", &EngineSession::push_move,
+             "play a move in algebraic notation, returns False if it's illegal",
+             py::arg("move"))
+        .def("pop_move", &EngineSession::pop_move,
+             "take back the last move, returns False if there is none")
+        .def("search", &EngineSession::search,
+             "search the current position and return the best move ('' if there is none)",
+             py::arg("depth") = 0, py::arg("movetime") = 0, py::arg("nodes") = 0)
+        
+        // background search: start it, poll() for progress, stop() it early, result() for the move
+        .def("start_search", &EngineSession::start_search,
+             "start searching the current position on a background thread and return at once",
+             py::arg("depth") = 0, py::arg("movetime") = 0, py::arg("nodes") = 0, py::arg("infinite") = false)
+        .def("poll", &EngineSession::poll,
+             "reports (SearchInfo) of the iterations completed since the last poll")
+        .def("stop", &EngineSession::stop,
+             "ask the background search to finish as soon as possible")
+        .def_property_readonly("is_searching", &EngineSession::is_searching)
+        .def("wait", &EngineSession::wait,
+             "wait up to timeout seconds (forever if negative) for the background search, True once it's done",
+             py::arg("timeout") = -1.0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("result", &EngineSession::result,
+             "best move of the background search, waiting for it to finish ('' if there is none or no search was started)",
+             py::call_guard<py::gil_scoped_release>())
+        .def("evaluate", &EngineSession::evaluate,
+             "static evaluation of the current position from white's point of view")
+        .def("fen", &EngineSession::fen)
+        .def("legal_moves", &EngineSession::legal_moves)
+        .def("in_check", &EngineSession::in_check)
+        .def("is_draw", &EngineSession::is_draw)
+        .def_property_readonly("moves", &EngineSession::get_moves, "moves played since the last set_position")
+        .def_property_readonly("nodes_searched", &EngineSession::nodes_searched, "nodes searched by the last search")
+        .def_property_readonly("last_info", &EngineSession::last_info, "report of the last completed iteration")
+        .def_property("depth", &EngineSession::get_depth, &EngineSession::set_depth)
+        .def_property("threads", &EngineSession::get_threads, &EngineSession::set_threads)
+        .def("set_hash_size", &EngineSession::set_hash_size, "resize the hash table in MB (clears it)",
+             py::arg("megabytes"));
 }
@@ -28,6 +28,14 @@ class EngineWrapper:
         # init the engine with the specified search depth
         self.depth = depth
         self.nodes_searched = 0
+        # one engine for the whole game, so its hash table and history carry over between moves.
+        # it follows the game through push_move, which keeps the earlier positions around for
+        # repetition detection
+        self.session = chess_engine.Engine(depth=depth) if ENGINE_AVAILABLE else None
+        # background search state (see start_thinking)
+        self.thinking = False
+        self.thinking_board = None
+        self.think_start = 0.0
         print(f"engine initialized with depth {depth}")
         if ENGINE_AVAILABLE:
             print("C++ chess engine is available")
@@ -37,8 +45,30 @@ class EngineWrapper:
     def set_depth(self, depth):
         # set the search depth
         self.depth = depth
+        if self.session is not None:
+            self.session.depth = depth
         print(f"engine depth set to {depth}")
     
+    def new_game(self, board):
+        # start a new game from the board's position, forgetting the old game and hash table
+        if self.session is not None:
+            self.session.new_game(board.to_fen())
+    
+    def push_move(self, move):
+        # tell the engine about a move played on the board (by either side)
+        if self.session is not None and not self.session.push_move(move.to_algebraic()):
+            # the board and the engine disagree now, _sync sets the position up again before the next search
+            print(f"engine couldn't follow move {move.to_algebraic()}, resyncing before the next search")
+    
+    def _sync(self, board):
+        # make sure the engine is on the board's position, only falls back to a fresh set_position
+        # (losing the game history) when they got out of step. the move counters aren't compared,
+        # the GUI's bookkeeping of them doesn't have to match the engine's
+        fen = board.to_fen()
+        if self.session.fen().split()[:4] != fen.split()[:4]:
+            print("engine out of sync with the board, setting up the position from FEN")
+            self.session.set_position(fen)
+    
     def get_best_move(self, board):
         # get the best move for the current position
         start_time = time.time()
@@ -53,36 +83,19 @@ class EngineWrapper:
             return move
         
         try:
-            # get the FEN representation of the board
-            fen = board.to_fen()
-            
             # use the C++ engine to get the best move as algebraic notation
             start_time = time.time()
-            move_str = chess_engine.get_best_move(fen, self.depth)
+            self._sync(board)
+            move_str = self.session.search()
             elapsed = time.time() - start_time
+            self.nodes_searched = self.session.nodes_searched
             
-            # parse the algebraic notation into a Move object
-            from_pos = Position.from_algebraic(move_str[:2])
-            to_pos = Position.from_algebraic(move_str[2:4])
-            
-            # handle promotion if present
-            promotion = None
-            if len(move_str) > 4:
-                promotion_map = {
-                    'q': PieceType.QUEEN,
-                    'r': PieceType.ROOK,
-                    'b': PieceType.BISHOP,
-                    'n': PieceType.KNIGHT
-                }
-                promotion = promotion_map.get(move_str[4].lower())
-            
-            # create the move object
-            move = Move(from_pos, to_pos, promotion)
+            if not move_str:
+                print("engine has no legal move")
+                return None
             
-            # estimate nodes searched (we don't have direct access in simplified binding)
-            self.nodes_searched = int(1000 * self.depth * elapsed)  # Rough estimate
-            
-            print(f"engine move: {move} (in {elapsed:.2f} seconds, ~{self.nodes_searched} nodes)")
+            move = self._parse_move(move_str)
+            print(f"engine move: {move} (in {elapsed:.2f} seconds, {self.nodes_searched} nodes)")
             return move
             
         except Exception as e:
@@ -93,10 +106,75 @@ class EngineWrapper:
             print(f"engine move: {move} (in {elapsed:.2f} seconds, 0 nodes)")
             return move
     
+    def start_thinking(self, board):
+        # start searching the position in the background, the move is picked up with poll_move
+        # so the caller's event loop keeps running meanwhile
+        self.thinking = True
+        self.thinking_board = board
+        self.think_start = time.time()
+        
+        if ENGINE_AVAILABLE:
+            try:
+                self._sync(board)
+                self.session.start_search()
+            except Exception as e:
+                print(f"error starting C++ engine search: {e}")
+    
+    def is_thinking(self):
+        # whether a search started by start_thinking hasn't been collected by poll_move yet
+        return self.thinking
+    
+    def poll_move(self):
+        # the engine's move once the background search is done, None while it's still thinking
+        if not self.thinking:
+            return None
+        if ENGINE_AVAILABLE and self.session.is_searching:
+            return None
+        
+        self.thinking = False
+        if not ENGINE_AVAILABLE:
+            return self.get_best_move(self.thinking_board)
+        
+        try:
+            move_str = self.session.result()
+            elapsed = time.time() - self.think_start
+            self.nodes_searched = self.session.nodes_searched
+            
+            if not move_str:
+                print("engine has no legal move")
+                return None
+            
+            move = self._parse_move(move_str)
+            print(f"engine move: {move} (in {elapsed:.2f} seconds, {self.nodes_searched} nodes)")
+            return move
+        except Exception as e:
+            print(f"error using C++ engine: {e}. Falling back to random move.")
+            moves = self._get_legal_moves_python(self.thinking_board)
+            return random.choice(moves) if moves else None
+    
     def get_nodes_searched(self):
         # get the number of nodes searched in the last search
         return self.nodes_searched
     
+    def _parse_move(self, move_str):
+        # parse the algebraic notation into a Move object
+        from_pos = Position.from_algebraic(move_str[:2])
+        to_pos = Position.from_algebraic(move_str[2:4])
+        
+        # handle promotion if present
+        promotion = None
+        if len(move_str) > 4:
+            promotion_map = {
+                'q': PieceType.QUEEN,
+                'r': PieceType.ROOK,
+                'b': PieceType.BISHOP,
+                'n': PieceType.KNIGHT
+            }
+            promotion = promotion_map.get(move_str[4].lower())
+        
+        # create the move object
+        return Move(from_pos, to_pos, promotion)
+    
     def _get_legal_moves_python(self, board):
         # get legal moves using Python implementation (fallback)
         from chess_move_generator import MoveGenerator
@@ -20,6 +20,7 @@ def main():
     
     # init the engine
     engine = EngineWrapper(depth=4)  # Search 4 moves ahead
+    engine.new_game(board)
     
     # game state tracking
     game_over = False
@@ -85,6 +86,7 @@ def main():
                 move_success = move_generator.make_move_on_board(board, player_move)
                 if move_success:
                     print(f"You moved: {player_move.to_algebraic()}")
+                    engine.push_move(player_move)
                     
                     # check if this move resulted in checkmate or stalemate
                     move_generator = MoveGenerator(board)
@@ -103,12 +105,21 @@ def main():
                 else:
                     print(f"Invalid move: {player_move.to_algebraic()}")
         else:
-            # engine's turn (black)
-            print("Engine is thinking...")
-            start_time = time.time()
+            # engine's turn (black), it searches in the background so the window stays responsive
+            if not engine.is_thinking():
+                print("Engine is thinking...")
+                start_time = time.time()
+                engine.start_thinking(board)
             
-            # get the best move from the engine
-            engine_move = engine.get_best_move(board)
+            for event in pygame.event.get():
+                if event.type == pygame.QUIT:
+                    running = False
+            
+            # get the best move from the engine once it's done
+            engine_move = engine.poll_move()
+            if engine.is_thinking():
+                pygame.time.delay(20)
+                continue
             
             end_time = time.time()
             elapsed = end_time - start_time
@@ -123,7 +134,8 @@ def main():
                 
                 # make the engine's move
                 move_generator = MoveGenerator(board)
-                move_generator.make_move_on_board(board, engine_move)
+                if move_generator.make_move_on_board(board, engine_move):
+                    engine.push_move(engine_move)
                 
                 # check if this move resulted in checkmate or stalemate
                 move_generator = MoveGenerator(board)
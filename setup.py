@@ -6,10 +6,16 @@ ext_modules = [
         "chess_engine",
         ["python_gui/engine_binding.cpp", 
          "src/chess/piece.cpp",
+         "src/chess/attacks.cpp",
+         "src/chess/zobrist.cpp",
+         "src/chess/psqt.cpp",
+         "src/chess/transposition.cpp",
          "src/chess/board.cpp",
          "src/chess/board_moves.cpp", 
+         "src/chess/packed.cpp",
          "src/chess/engine.cpp",
-         "src/chess/evaluate.cpp"],
+         "src/chess/evaluate.cpp",
+         "src/chess/movepick.cpp"],
         include_dirs=["include"],
         extra_compile_args=["-std=c++17"],
     ),
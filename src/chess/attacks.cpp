@@ -0,0 +1,188 @@
+#include "chess/attacks.h"
+#include <utility>
+
+namespace chess {
+namespace attacks {
+
+Bitboard pawnTable[3][64];
+Bitboard knightTable[64];
+Bitboard kingTable[64];
+Magic bishopMagics[64];
+Magic rookMagics[64];
+Bitboard betweenTable[64][64];
+Bitboard lineTable[64][64];
+
+namespace {
+
+// one table for every square's slice (sizes are the well known totals for
+// rooks and bishops with the edge squares masked off)
+Bitboard rookTable[0x19000];
+Bitboard bishopTable[0x1480];
+
+const int bishopDirections[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+const int rookDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// add the square at (file, rank) to the set if it is on the board
+Bitboard offsetBB(int square, int fileOffset, int rankOffset) {
+    int file = (square & 7) + fileOffset;
+    int rank = (square >> 3) + rankOffset;
+    if (file < 0 || file > 7 || rank < 0 || rank > 7) return 0;
+    return squareBB(rank * 8 + file);
+}
+
+// walk the rays the slow way, only used to fill the tables
+Bitboard slidingAttacks(const int directions[4][2], int square, Bitboard occupied) {
+    Bitboard result = 0;
+    
+    for (int d = 0; d < 4; d++) {
+        for (int i = 1; i < 8; i++) {
+            Bitboard target = offsetBB(square, i * directions[d][0], i * directions[d][1]);
+            if (!target) break;
+            
+            result |= target;
+            if (occupied & target) break;
+        }
+    }
+    
+    return result;
+}
+
+// xorshift64* generator, fixed seed so the magics are the same every run
+class Prng {
+    uint64_t state;
+    
+public:
+    explicit Prng(uint64_t seed) : state(seed) {}
+    
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+    
+    // numbers with few bits set make better magic candidates
+    uint64_t sparse() { return next() & next() & next(); }
+};
+
+void initMagics(const int directions[4][2], Bitboard* table, Magic magics[64]) {
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+    
+    // per-rank seeds known to find all magics after few tries
+    const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+    
+    for (int square = 0; square < 64; square++) {
+        Magic& m = magics[square];
+        
+        // the edges never block anything, unless the piece stands on them
+        Bitboard edges = ((rankBB(0) | rankBB(7)) & ~rankBB(square >> 3)) |
+                         ((fileBB(0) | fileBB(7)) & ~fileBB(square & 7));
+        m.mask = slidingAttacks(directions, square, 0) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        if (square == 0) {
+            m.table = table;
+        }
+        
+        // enumerate every subset of the mask (carry-rippler trick)
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(directions, square, b);
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        
+        if (square < 63) {
+            // the next square's slice starts right after this one
+            magics[square + 1].table = m.table + size;
+        }
+        
+#if defined(__BMI2__)
+        m.magic = 0;
+        for (int i = 0; i < size; i++) {
+            m.table[m.index(occupancy[i])] = reference[i];
+        }
+#else
+        // try random magics until one maps every subset without a bad collision
+        Prng prng(seeds[square >> 3]);
+        for (int i = 0; i < size; ) {
+            do {
+                m.magic = prng.sparse();
+            } while (popCount((m.magic * m.mask) >> 56) < 6);
+            
+            attempt++;
+            for (i = 0; i < size; i++) {
+                unsigned idx = m.index(occupancy[i]);
+                
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.table[idx] = reference[i];
+                } else if (m.table[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+// build the tables before main runs
+struct Initializer {
+    Initializer() { init(); }
+} initializer;
+
+} // namespace
+
+void init() {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+    
+    for (int square = 0; square < 64; square++) {
+        pawnTable[static_cast<int>(Color::WHITE)][square] = offsetBB(square, -1, 1) | offsetBB(square, 1, 1);
+        pawnTable[static_cast<int>(Color::BLACK)][square] = offsetBB(square, -1, -1) | offsetBB(square, 1, -1);
+        
+        knightTable[square] = 0;
+        for (auto offset : {std::pair<int, int>{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
+                            {1, -2}, {1, 2}, {2, -1}, {2, 1}}) {
+            knightTable[square] |= offsetBB(square, offset.first, offset.second);
+        }
+        
+        kingTable[square] = 0;
+        for (int df = -1; df <= 1; df++) {
+            for (int dr = -1; dr <= 1; dr++) {
+                if (df != 0 || dr != 0) {
+                    kingTable[square] |= offsetBB(square, df, dr);
+                }
+            }
+        }
+    }
+    
+    initMagics(bishopDirections, bishopTable, bishopMagics);
+    initMagics(rookDirections, rookTable, rookMagics);
+    
+    // rays between squares, built from the slider tables
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            betweenTable[from][to] = 0;
+            lineTable[from][to] = 0;
+            
+            if (from == to) continue;
+            
+            if (bishopAttacks(from, 0) & squareBB(to)) {
+                lineTable[from][to] = (bishopAttacks(from, 0) & bishopAttacks(to, 0)) | squareBB(from) | squareBB(to);
+                betweenTable[from][to] = bishopAttacks(from, squareBB(to)) & bishopAttacks(to, squareBB(from));
+            } else if (rookAttacks(from, 0) & squareBB(to)) {
+                lineTable[from][to] = (rookAttacks(from, 0) & rookAttacks(to, 0)) | squareBB(from) | squareBB(to);
+                betweenTable[from][to] = rookAttacks(from, squareBB(to)) & rookAttacks(to, squareBB(from));
+            }
+        }
+    }
+}
+
+} // namespace attacks
+} // namespace chess
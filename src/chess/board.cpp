@@ -1,6 +1,9 @@
 #include "chess/board.h"
+#include "chess/attacks.h"
+#include "chess/psqt.h"
+#include "chess/zobrist.h"
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
 
 namespace chess {
 
@@ -19,10 +22,10 @@ Position Position::fromAlgebraic(const std::string& algebraic) {
 
 // move methods
 std::string Move::toAlgebraic() const {
-    std::string result = from.toAlgebraic() + to.toAlgebraic();
-    if (promotion != PieceType::EMPTY) {
+    std::string result = from().toAlgebraic() + to().toAlgebraic();
+    if (promotion() != PieceType::EMPTY) {
         char promotionChar = ' ';
-        switch (promotion) {
+        switch (promotion()) {
             case PieceType::QUEEN:  promotionChar = 'q'; break;
             case PieceType::ROOK:   promotionChar = 'r'; break;
             case PieceType::BISHOP: promotionChar = 'b'; break;
@@ -39,6 +42,7 @@ Move Move::fromAlgebraic(const std::string& algebraic) {
     
     Position from = Position::fromAlgebraic(algebraic.substr(0, 2));
     Position to = Position::fromAlgebraic(algebraic.substr(2, 2));
+    if (!from.isValid() || !to.isValid()) return Move();
     
     PieceType promotion = PieceType::EMPTY;
     if (algebraic.length() > 4) {
@@ -55,130 +59,318 @@ Move Move::fromAlgebraic(const std::string& algebraic) {
     return Move(from, to, promotion);
 }
 
-// board methods
-Board::Board() : sideToMove(Color::WHITE), 
-                whiteCanCastleKingside(false), whiteCanCastleQueenside(false),
-                blackCanCastleKingside(false), blackCanCastleQueenside(false),
-                halfMoveClock(0), fullMoveNumber(1) {
-    // init mt board
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            pieces[rank][file] = Piece();
-        }
+namespace {
+
+// FEN fields are separated by spaces, tolerate tabs and a line ending left on the string too
+bool isFenSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// take the next field off the front of a FEN, empty when there are none left
+std::string_view nextField(std::string_view& fen) {
+    size_t start = 0;
+    while (start < fen.size() && isFenSpace(fen[start])) {
+        start++;
+    }
+    
+    size_t end = start;
+    while (end < fen.size() && !isFenSpace(fen[end])) {
+        end++;
+    }
+    
+    std::string_view field = fen.substr(start, end - start);
+    fen.remove_prefix(end);
+    return field;
+}
+
+// a move counter, plain digits only (few enough that it can't overflow)
+bool parseCounter(std::string_view field, int& value) {
+    if (field.empty() || field.size() > 9) return false;
+    
+    value = 0;
+    for (char c : field) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+// write a non-negative number, returns the position after it
+char* writeNumber(char* out, int value) {
+    char digits[12];
+    int count = 0;
+    unsigned int remaining = static_cast<unsigned int>(value < 0 ? 0 : value);
+    do {
+        digits[count++] = static_cast<char>('0' + remaining % 10);
+        remaining /= 10;
+    } while (remaining);
+    
+    while (count) {
+        *out++ = digits[--count];
     }
+    return out;
+}
+
+} // namespace
+
+// board methods
+Board::Board() {
+    // enough room for a long game plus a deep search without reallocating
+    undoStack.reserve(512);
+    reset();
 }
 
 Board::Board(const std::string& fen) : Board() {
-    std::istringstream ss(fen);
-    std::string boardStr, activeColor, castling, enPassant, halfMove, fullMove;
+    if (!loadFEN(fen)) {
+        throw std::invalid_argument("invalid FEN: " + fen);
+    }
+}
+
+void Board::reset() {
+    mailbox.fill(Piece());
+    typeBB.fill(0);
+    colorBB.fill(0);
+    sideToMove = Color::WHITE;
+    castlingRights = 0;
+    enPassantTarget = Position(-1, -1);
+    halfMoveClock = 0;
+    fullMoveNumber = 1;
+    key = 0;
+    pawnKey = 0;
+    mgScore = 0;
+    egScore = 0;
+    phase = 0;
+    undoStack.clear();
+}
+
+bool Board::loadFEN(std::string_view fen) {
+    reset();
     
-    // prse board position
-    ss >> boardStr;
+    // piece placement, rank 8 first
+    bool valid = true;
     int rank = 7;
     int file = 0;
     
-    for (char c : boardStr) {
+    for (char c : nextField(fen)) {
         if (c == '/') {
+            valid = valid && file == 8 && rank > 0;
             rank--;
             file = 0;
-        } else if (std::isdigit(c)) {
+        } else if (c >= '1' && c <= '8') {
             file += c - '0';
+            valid = valid && file <= 8;
         } else {
-            pieces[rank][file] = Piece::fromFEN(c);
+            // a pawn can't stand on the first or last rank, move generation would push it off the board
+            Piece piece = Piece::fromFEN(c);
+            valid = valid && !piece.isEmpty() && file < 8 &&
+                    !(piece.getType() == PieceType::PAWN && (rank == 0 || rank == 7));
+            if (!valid) break;
+            setPiece(Position(file, rank), piece);
             file++;
         }
     }
     
-    // parse active color
-    ss >> activeColor;
-    sideToMove = (activeColor == "w") ? Color::WHITE : Color::BLACK;
+    // every rank has to be there and add up to eight squares
+    valid = valid && rank == 0 && file == 8;
     
-    // parse castling rights
-    ss >> castling;
-    whiteCanCastleKingside = (castling.find('K') != std::string::npos);
-    whiteCanCastleQueenside = (castling.find('Q') != std::string::npos);
-    blackCanCastleKingside = (castling.find('k') != std::string::npos);
-    blackCanCastleQueenside = (castling.find('q') != std::string::npos);
+    // active color
+    std::string_view active = nextField(fen);
+    valid = valid && (active == "w" || active == "b");
+    if (active == "b") {
+        sideToMove = Color::BLACK;
+    }
     
-    // parse en passant target square
-    ss >> enPassant;
-    if (enPassant != "-") {
-        enPassantTarget = Position::fromAlgebraic(enPassant);
+    // castling rights
+    std::string_view castling = nextField(fen);
+    valid = valid && !castling.empty();
+    if (castling != "-") {
+        for (char c : castling) {
+            switch (c) {
+                case 'K': castlingRights |= WHITE_KINGSIDE;  break;
+                case 'Q': castlingRights |= WHITE_QUEENSIDE; break;
+                case 'k': castlingRights |= BLACK_KINGSIDE;  break;
+                case 'q': castlingRights |= BLACK_QUEENSIDE; break;
+                default: valid = false; break;
+            }
+        }
     }
     
-    // parse half move clock and full move number
-    ss >> halfMove >> fullMove;
-    halfMoveClock = std::stoi(halfMove);
-    fullMoveNumber = std::stoi(fullMove);
+    // en passant target square, only ever on the third or sixth rank
+    std::string_view enPassant = nextField(fen);
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' &&
+        (enPassant[1] == '3' || enPassant[1] == '6')) {
+        enPassantTarget = Position(enPassant[0] - 'a', enPassant[1] - '1');
+    } else if (enPassant != "-") {
+        valid = false;
+    }
+    
+    // half move clock and full move number, plenty of EPD-style FENs don't have them
+    std::string_view halfMove = nextField(fen);
+    std::string_view fullMove = nextField(fen);
+    if (!halfMove.empty()) {
+        valid = valid && parseCounter(halfMove, halfMoveClock) &&
+                (fullMove.empty() || parseCounter(fullMove, fullMoveNumber));
+    }
+    
+    if (!valid) {
+        reset();
+        return false;
+    }
+    
+    // setPiece hashed the pieces already
+    key ^= stateKey();
+    return true;
 }
 
 Piece Board::getPiece(const Position& pos) const {
     if (!pos.isValid()) return Piece();
-    return pieces[pos.rank][pos.file];
+    return mailbox[pos.toIndex()];
 }
 
 void Board::setPiece(const Position& pos, const Piece& piece) {
     if (!pos.isValid()) return;
-    pieces[pos.rank][pos.file] = piece;
+    
+    int square = pos.toIndex();
+    Bitboard bb = squareBB(square);
+    
+    // clear whatever was on the square
+    Piece old = mailbox[square];
+    if (!old.isEmpty()) {
+        typeBB[static_cast<int>(old.getType())] &= ~bb;
+        colorBB[static_cast<int>(old.getColor())] &= ~bb;
+    }
+    
+    mailbox[square] = piece;
+    if (!piece.isEmpty()) {
+        typeBB[static_cast<int>(piece.getType())] |= bb;
+        colorBB[static_cast<int>(piece.getColor())] |= bb;
+    }
+    
+    // empty squares have a zero key, so this is right for captures and clears too
+    key ^= zobrist::pieceKey(old, square) ^ zobrist::pieceKey(piece, square);
+    if (old.getType() == PieceType::PAWN) {
+        pawnKey ^= zobrist::pieceKey(old, square);
+    }
+    if (piece.getType() == PieceType::PAWN) {
+        pawnKey ^= zobrist::pieceKey(piece, square);
+    }
+    
+    // same for the evaluation sums, empty squares score nothing
+    const psqt::Score& removed = psqt::pieceScore(old, square);
+    const psqt::Score& added = psqt::pieceScore(piece, square);
+    mgScore += added.mg - removed.mg;
+    egScore += added.eg - removed.eg;
+    phase += psqt::phaseWeight[static_cast<int>(piece.getType())] - psqt::phaseWeight[static_cast<int>(old.getType())];
+}
+
+void Board::toggleSideToMove() {
+    // whether the en passant square counts depends on who is to move
+    key ^= enPassantKey();
+    sideToMove = opposite(sideToMove);
+    key ^= zobrist::sideKey ^ enPassantKey();
+}
+
+uint64_t Board::enPassantKey() const {
+    if (!enPassantTarget.isValid()) {
+        return 0;
+    }
+    
+    // a pawn of the side to move standing where an enemy pawn on the target would attack
+    Bitboard capturers = attacks::pawnAttacks(opposite(sideToMove), enPassantTarget.toIndex()) &
+                         getPieces(PieceType::PAWN, sideToMove);
+    return capturers ? zobrist::enPassantKeys[enPassantTarget.file] : 0;
+}
+
+uint64_t Board::computeHash() const {
+    uint64_t hash = 0;
+    
+    Bitboard occupied = getOccupied();
+    while (occupied) {
+        int square = popLsb(occupied);
+        hash ^= zobrist::pieceKey(mailbox[square], square);
+    }
+    
+    return hash ^ stateKey();
+}
+
+uint64_t Board::stateKey() const {
+    uint64_t hash = zobrist::castlingKeys[castlingRights] ^ enPassantKey();
+    return sideToMove == Color::BLACK ? hash ^ zobrist::sideKey : hash;
+}
+
+Position Board::getKingPosition(Color color) const {
+    Bitboard king = getPieces(PieceType::KING, color);
+    if (!king) return Position(-1, -1);
+    return Position::fromIndex(lsb(king));
 }
 
 std::string Board::toFEN() const {
-    std::stringstream ss;
+    char buffer[MAX_FEN_LENGTH];
+    return std::string(buffer, writeFEN(buffer));
+}
+
+size_t Board::writeFEN(char* buffer) const {
+    char* out = buffer;
     
     // board position
     for (int rank = 7; rank >= 0; rank--) {
         int emptyCount = 0;
         
         for (int file = 0; file < 8; file++) {
-            Piece piece = pieces[rank][file];
+            Piece piece = mailbox[Position(file, rank).toIndex()];
             
             if (piece.isEmpty()) {
                 emptyCount++;
             } else {
                 if (emptyCount > 0) {
-                    ss << emptyCount;
+                    *out++ = static_cast<char>('0' + emptyCount);
                     emptyCount = 0;
                 }
-                ss << piece.toFEN();
+                *out++ = piece.toFEN();
             }
         }
         
         if (emptyCount > 0) {
-            ss << emptyCount;
+            *out++ = static_cast<char>('0' + emptyCount);
         }
         
         if (rank > 0) {
-            ss << '/';
+            *out++ = '/';
         }
     }
     
     // active color
-    ss << ' ' << (sideToMove == Color::WHITE ? 'w' : 'b');
+    *out++ = ' ';
+    *out++ = sideToMove == Color::WHITE ? 'w' : 'b';
     
     // castling rights
-    ss << ' ';
-    if (whiteCanCastleKingside || whiteCanCastleQueenside || 
-        blackCanCastleKingside || blackCanCastleQueenside) {
-        if (whiteCanCastleKingside) ss << 'K';
-        if (whiteCanCastleQueenside) ss << 'Q';
-        if (blackCanCastleKingside) ss << 'k';
-        if (blackCanCastleQueenside) ss << 'q';
+    *out++ = ' ';
+    if (castlingRights) {
+        if (castlingRights & WHITE_KINGSIDE) *out++ = 'K';
+        if (castlingRights & WHITE_QUEENSIDE) *out++ = 'Q';
+        if (castlingRights & BLACK_KINGSIDE) *out++ = 'k';
+        if (castlingRights & BLACK_QUEENSIDE) *out++ = 'q';
     } else {
-        ss << '-';
+        *out++ = '-';
     }
     
     // en passant target square
-    ss << ' ';
+    *out++ = ' ';
     if (enPassantTarget.isValid()) {
-        ss << enPassantTarget.toAlgebraic();
+        *out++ = static_cast<char>('a' + enPassantTarget.file);
+        *out++ = static_cast<char>('1' + enPassantTarget.rank);
     } else {
-        ss << '-';
+        *out++ = '-';
     }
     
     // half move clock and full move number
-    ss << ' ' << halfMoveClock << ' ' << fullMoveNumber;
+    *out++ = ' ';
+    out = writeNumber(out, halfMoveClock);
+    *out++ = ' ';
+    out = writeNumber(out, fullMoveNumber);
     
-    return ss.str();
+    *out = '\0';
+    return static_cast<size_t>(out - buffer);
 }
 
 void Board::print() const {
@@ -189,7 +381,7 @@ void Board::print() const {
         std::cout << rank + 1 << "|";
         
         for (int file = 0; file < 8; file++) {
-            std::cout << pieces[rank][file].toChar() << "|";
+            std::cout << mailbox[Position(file, rank).toIndex()].toChar() << "|";
         }
         
         std::cout << rank + 1 << std::endl;
@@ -1,173 +1,254 @@
 #include "chess/board.h"
+#include "chess/attacks.h"
+#include "chess/zobrist.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 namespace chess {
 
-bool Board::makeMove(const Move& move) {
-    // check if the move is valid
-    if (!move.from.isValid() || !move.to.isValid()) {
-        return false;
-    }
+namespace {
+
+// a castling move: the right it needs and where the king and rook go
+struct CastlingMove {
+    CastlingRight right;
+    int kingFrom, kingTo;
+    int rookFrom, rookTo;
+};
+
+const CastlingMove castlingMoves[4] = {
+    {WHITE_KINGSIDE,  4,  6,  7,  5},   // e1g1, h1f1
+    {WHITE_QUEENSIDE, 4,  2,  0,  3},   // e1c1, a1d1
+    {BLACK_KINGSIDE,  60, 62, 63, 61},  // e8g8, h8f8
+    {BLACK_QUEENSIDE, 60, 58, 56, 59}   // e8c8, a8d8
+};
+
+// rights that survive a move from or to each square (king and rook home squares clear some)
+struct CastlingMasks {
+    uint8_t mask[64];
     
+    CastlingMasks() {
+        for (int square = 0; square < 64; square++) {
+            mask[square] = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
+        }
+        for (const CastlingMove& castling : castlingMoves) {
+            mask[castling.kingFrom] &= ~castling.right;
+            mask[castling.rookFrom] &= ~castling.right;
+        }
+    }
+} const castlingMasks;
+
+} // namespace
+
+bool Board::makeMove(const Move& move) {
     // get the piece at the from position
-    Piece piece = getPiece(move.from);
+    Piece piece = getPiece(move.from());
     
     // check if there is a piece at the from position and it's the correct color
     if (piece.isEmpty() || piece.getColor() != sideToMove) {
         return false;
     }
     
-    // check if the move is legal
-    if (!isLegalMove(move)) {
-        return false;
+    // find the matching legal move, it carries the flags the caller may not know about
+    // (a promotion without a piece means queen, idc man)
+    MoveList legalMoves = generateLegalMoves();
+    for (const Move& legalMove : legalMoves) {
+        if (legalMove.fromSquare() != move.fromSquare() || legalMove.toSquare() != move.toSquare()) {
+            continue;
+        }
+        
+        PieceType wanted = move.promotion();
+        if (legalMove.promotion() == wanted || 
+            (wanted == PieceType::EMPTY && legalMove.promotion() == PieceType::QUEEN)) {
+            makeMoveUnchecked(legalMove);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void Board::makeMoveUnchecked(const Move& move) {
+    Piece piece = getPiece(move.from());
+    
+    // remember what we need to take the move back
+    UndoInfo undo;
+    undo.move = move;
+    undo.moved = piece;
+    undo.captured = getPiece(move.to());
+    undo.castlingRights = castlingRights;
+    undo.enPassantTarget = enPassantTarget;
+    undo.halfMoveClock = halfMoveClock;
+    undo.hash = key;
+    undoStack.push_back(undo);
+    
+    // the old en passant square stops counting
+    key ^= enPassantKey();
+    
+    // update the clocks (the half move clock resets on captures and pawn moves)
+    if (piece.getType() == PieceType::PAWN || !undo.captured.isEmpty()) {
+        halfMoveClock = 0;
+    } else {
+        halfMoveClock++;
+    }
+    if (sideToMove == Color::BLACK) {
+        fullMoveNumber++;
     }
     
-    // handle captures
-    Piece targetPiece = getPiece(move.to);
-    bool isCapture = !targetPiece.isEmpty();
+    // moving a king or rook off its home square, or capturing on one, loses castling rights
+    key ^= zobrist::castlingKeys[castlingRights];
+    castlingRights &= castlingMasks.mask[move.fromSquare()] & castlingMasks.mask[move.toSquare()];
+    key ^= zobrist::castlingKeys[castlingRights];
     
-    // make the move
-    setPiece(move.to, piece);
-    setPiece(move.from, Piece());
+    // a double pawn push leaves an en passant target behind it
+    enPassantTarget = Position(-1, -1);
+    if (piece.getType() == PieceType::PAWN && abs(move.toSquare() - move.fromSquare()) == 16) {
+        enPassantTarget = Position::fromIndex((move.fromSquare() + move.toSquare()) / 2);
+    }
     
-    // handle pawn promotion
-    if (piece.getType() == PieceType::PAWN && 
-        ((sideToMove == Color::WHITE && move.to.rank == 7) || 
-         (sideToMove == Color::BLACK && move.to.rank == 0))) {
-        if (move.promotion != PieceType::EMPTY) {
-            setPiece(move.to, Piece(move.promotion, sideToMove));
-        } else {
-            // default promotion to queen idc man
-            setPiece(move.to, Piece(PieceType::QUEEN, sideToMove));
+    // make the move
+    setPiece(move.to(), piece);
+    setPiece(move.from(), Piece());
+    
+    // castling also moves the rook
+    if (move.flag() == Move::CASTLING) {
+        for (const CastlingMove& castling : castlingMoves) {
+            if (castling.kingTo == move.toSquare()) {
+                Position rookFrom = Position::fromIndex(castling.rookFrom);
+                setPiece(Position::fromIndex(castling.rookTo), getPiece(rookFrom));
+                setPiece(rookFrom, Piece());
+                break;
+            }
         }
     }
     
-    // toggle side to move
-    toggleSideToMove();
+    // en passant takes the pawn that is next to us, not on the target square
+    if (move.flag() == Move::EN_PASSANT) {
+        Position capturedPos(move.to().file, move.from().rank);
+        undoStack.back().captured = getPiece(capturedPos);
+        setPiece(capturedPos, Piece());
+    }
     
-    return true;
+    // handle pawn promotion
+    if (move.flag() == Move::PROMOTION) {
+        setPiece(move.to(), Piece(move.promotion(), sideToMove));
+    }
+    
+    // toggle side to move (the en passant key is added for the new side)
+    sideToMove = opposite(sideToMove);
+    key ^= zobrist::sideKey ^ enPassantKey();
 }
 
-bool Board::isUnderAttack(const Position& pos, Color attackingColor) const {
-    // check for pawn attacks
-    int pawnDirection = (attackingColor == Color::WHITE) ? 1 : -1;
-    Position leftAttack(pos.file - 1, pos.rank - pawnDirection);
-    Position rightAttack(pos.file + 1, pos.rank - pawnDirection);
-    
-    if (leftAttack.isValid()) {
-        Piece attacker = getPiece(leftAttack);
-        if (!attacker.isEmpty() && attacker.getColor() == attackingColor && 
-            attacker.getType() == PieceType::PAWN) {
-            return true;
-        }
+void Board::unmakeMove() {
+    if (undoStack.empty()) {
+        return;
     }
     
-    if (rightAttack.isValid()) {
-        Piece attacker = getPiece(rightAttack);
-        if (!attacker.isEmpty() && attacker.getColor() == attackingColor && 
-            attacker.getType() == PieceType::PAWN) {
-            return true;
-        }
+    const UndoInfo& undo = undoStack.back();
+    
+    // put the pieces back (this also undoes promotions)
+    setPiece(undo.move.from(), undo.moved);
+    if (undo.move.flag() == Move::EN_PASSANT) {
+        setPiece(undo.move.to(), Piece());
+        setPiece(Position(undo.move.to().file, undo.move.from().rank), undo.captured);
+    } else {
+        setPiece(undo.move.to(), undo.captured);
     }
     
-    // check for knight attacks
-    const std::vector<std::pair<int, int>> knightMoves = { // vectors of pairs of int
-        {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}
-    };
-    
-    for (const auto& move : knightMoves) {
-        Position knightPos(pos.file + move.first, pos.rank + move.second);
-        if (knightPos.isValid()) {
-            Piece attacker = getPiece(knightPos);
-            if (!attacker.isEmpty() && attacker.getColor() == attackingColor && 
-                attacker.getType() == PieceType::KNIGHT) {
-                return true;
+    // and the rook after castling
+    if (undo.move.flag() == Move::CASTLING) {
+        for (const CastlingMove& castling : castlingMoves) {
+            if (castling.kingTo == undo.move.toSquare()) {
+                Position rookTo = Position::fromIndex(castling.rookTo);
+                setPiece(Position::fromIndex(castling.rookFrom), getPiece(rookTo));
+                setPiece(rookTo, Piece());
+                break;
             }
         }
     }
     
-    // check for sliding piece attacks (bishop, rook, queen) (smooth criminal)
-    const std::vector<std::pair<int, int>> bishopDirections = {
-        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
-    };
+    // restore the state we can't recompute
+    castlingRights = undo.castlingRights;
+    enPassantTarget = undo.enPassantTarget;
+    halfMoveClock = undo.halfMoveClock;
     
-    const std::vector<std::pair<int, int>> rookDirections = {
-        {-1, 0}, {1, 0}, {0, -1}, {0, 1}
-    };
+    sideToMove = opposite(sideToMove);
+    if (sideToMove == Color::BLACK) {
+        fullMoveNumber--;
+    }
     
-    // check bishop-like moves (bishop, queen) (diags)
-    for (const auto& dir : bishopDirections) {
-        for (int i = 1; i < 8; i++) {
-            Position checkPos(pos.file + i * dir.first, pos.rank + i * dir.second);
-            if (!checkPos.isValid()) {
-                break;
-            }
-            
-            Piece piece = getPiece(checkPos);
-            if (!piece.isEmpty()) {
-                if (piece.getColor() == attackingColor && 
-                    (piece.getType() == PieceType::BISHOP || piece.getType() == PieceType::QUEEN)) {
-                    return true;
-                }
-                break;
-            }
-        }
+    // setPiece kept the hash moving, but the saved one is simpler than undoing every term
+    key = undo.hash;
+    undoStack.pop_back();
+}
+
+void Board::makeNullMove() {
+    UndoInfo undo;
+    undo.move = Move();
+    undo.castlingRights = castlingRights;
+    undo.enPassantTarget = enPassantTarget;
+    undo.halfMoveClock = halfMoveClock;
+    undo.hash = key;
+    undoStack.push_back(undo);
+    
+    key ^= enPassantKey();
+    enPassantTarget = Position(-1, -1);
+    
+    // a null move isn't a real move, so repetitions across it would be bogus
+    halfMoveClock = 0;
+    
+    sideToMove = opposite(sideToMove);
+    key ^= zobrist::sideKey;
+}
+
+void Board::unmakeNullMove() {
+    const UndoInfo& undo = undoStack.back();
+    
+    enPassantTarget = undo.enPassantTarget;
+    halfMoveClock = undo.halfMoveClock;
+    sideToMove = opposite(sideToMove);
+    key = undo.hash;
+    undoStack.pop_back();
+}
+
+bool Board::isUnderAttack(const Position& pos, Color attackingColor) const {
+    int square = pos.toIndex();
+    Bitboard occupied = getOccupied();
+    
+    // check for pawn attacks (a pawn of ours on this square would attack the same squares backwards)
+    if (attacks::pawnAttacks(opposite(attackingColor), square) & getPieces(PieceType::PAWN, attackingColor)) {
+        return true;
     }
     
-    // check rook-like moves (rook, queen)
-    for (const auto& dir : rookDirections) {
-        for (int i = 1; i < 8; i++) {
-            Position checkPos(pos.file + i * dir.first, pos.rank + i * dir.second);
-            if (!checkPos.isValid()) {
-                break;
-            }
-            
-            Piece piece = getPiece(checkPos);
-            if (!piece.isEmpty()) {
-                if (piece.getColor() == attackingColor && 
-                    (piece.getType() == PieceType::ROOK || piece.getType() == PieceType::QUEEN)) {
-                    return true;
-                }
-                break;
-            }
-        }
+    // check for knight attacks
+    if (attacks::knightAttacks(square) & getPieces(PieceType::KNIGHT, attackingColor)) {
+        return true;
     }
     
     // check for king attacks
-    const std::vector<std::pair<int, int>> kingMoves = {
-        {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
-    };
-    
-    for (const auto& move : kingMoves) {
-        Position kingPos(pos.file + move.first, pos.rank + move.second);
-        if (kingPos.isValid()) {
-            Piece attacker = getPiece(kingPos);
-            if (!attacker.isEmpty() && attacker.getColor() == attackingColor && 
-                attacker.getType() == PieceType::KING) {
-                return true;
-            }
-        }
+    if (attacks::kingAttacks(square) & getPieces(PieceType::KING, attackingColor)) {
+        return true;
+    }
+    
+    // check for sliding piece attacks (bishop, rook, queen) (smooth criminal)
+    Bitboard queens = getPieces(PieceType::QUEEN, attackingColor);
+    
+    // check bishop-like moves (bishop, queen) (diags)
+    if (attacks::bishopAttacks(square, occupied) & (getPieces(PieceType::BISHOP, attackingColor) | queens)) {
+        return true;
+    }
+    
+    // check rook-like moves (rook, queen)
+    if (attacks::rookAttacks(square, occupied) & (getPieces(PieceType::ROOK, attackingColor) | queens)) {
+        return true;
     }
     
     return false;
 }
 
 bool Board::isInCheck() const {
-    // find the king, hmmm
-    Position kingPos(-1, -1);
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Piece piece = pieces[rank][file];
-            if (!piece.isEmpty() && piece.getType() == PieceType::KING && 
-                piece.getColor() == sideToMove) {
-                kingPos = Position(file, rank);
-                break;
-            }
-        }
-        if (kingPos.isValid()) {
-            break;
-        }
-    }
+    // find the king, hmmm (one bitscan now)
+    Position kingPos = getKingPosition(sideToMove);
     
     if (!kingPos.isValid()) {
         // this shouldn't happen in a valid chess position but like good code habits and stuff
@@ -178,77 +259,290 @@ bool Board::isInCheck() const {
     return isUnderAttack(kingPos, (sideToMove == Color::WHITE) ? Color::BLACK : Color::WHITE);
 }
 
-std::vector<Move> Board::generateLegalMoves() const {
-    std::vector<Move> legalMoves;
+Bitboard Board::getAttackers(int square, Bitboard occupied) const {
+    Bitboard bishopsQueens = getPieces(PieceType::BISHOP) | getPieces(PieceType::QUEEN);
+    Bitboard rooksQueens = getPieces(PieceType::ROOK) | getPieces(PieceType::QUEEN);
+    
+    return (attacks::pawnAttacks(Color::WHITE, square) & getPieces(PieceType::PAWN, Color::BLACK)) |
+           (attacks::pawnAttacks(Color::BLACK, square) & getPieces(PieceType::PAWN, Color::WHITE)) |
+           (attacks::knightAttacks(square) & getPieces(PieceType::KNIGHT)) |
+           (attacks::kingAttacks(square) & getPieces(PieceType::KING)) |
+           (attacks::bishopAttacks(square, occupied) & bishopsQueens) |
+           (attacks::rookAttacks(square, occupied) & rooksQueens);
+}
+
+int Board::see(const Move& move) const {
+    if (move.flag() == Move::CASTLING) {
+        return 0;
+    }
     
-    // generate moves for all pieces of the current side to move
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = getPiece(pos);
-            
-            if (!piece.isEmpty() && piece.getColor() == sideToMove) {
-                std::vector<Move> pieceMoves = generatePseudoLegalMoves(pos);
+    int from = move.fromSquare();
+    int to = move.toSquare();
+    Bitboard occupied = getOccupied() ^ squareBB(from);
+    
+    // gain[d] is what the side making capture d wins, assuming it then gets recaptured
+    int gain[32];
+    int depth = 0;
+    gain[0] = mailbox[to].getValue();
+    int onSquare = mailbox[from].getValue();   // value of the piece that can be taken next
+    
+    if (move.flag() == Move::EN_PASSANT) {
+        gain[0] = Piece(PieceType::PAWN, Color::WHITE).getValue();
+        occupied ^= squareBB(to + (sideToMove == Color::WHITE ? -8 : 8));
+    } else if (move.flag() == Move::PROMOTION) {
+        int promoted = Piece(move.promotion(), Color::WHITE).getValue();
+        gain[0] += promoted - Piece(PieceType::PAWN, Color::WHITE).getValue();
+        onSquare = promoted;
+    }
+    
+    Bitboard bishopsQueens = getPieces(PieceType::BISHOP) | getPieces(PieceType::QUEEN);
+    Bitboard rooksQueens = getPieces(PieceType::ROOK) | getPieces(PieceType::QUEEN);
+    Bitboard attackers = getAttackers(to, occupied) & occupied;
+    Color side = opposite(sideToMove);
+    
+    while (true) {
+        Bitboard ours = attackers & getPieces(side);
+        if (!ours) {
+            break;
+        }
+        
+        // recapture with the least valuable piece
+        PieceType type = PieceType::PAWN;
+        Bitboard candidates = 0;
+        for (PieceType t : {PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP,
+                            PieceType::ROOK, PieceType::QUEEN, PieceType::KING}) {
+            candidates = ours & getPieces(t);
+            if (candidates) {
+                type = t;
+                break;
+            }
+        }
+        
+        depth++;
+        gain[depth] = onSquare - gain[depth - 1];
+        
+        // take the piece off and look for sliders that were behind it (x-rays)
+        occupied ^= candidates & (0 - candidates);
+        if (type == PieceType::PAWN || type == PieceType::BISHOP || type == PieceType::QUEEN) {
+            attackers |= attacks::bishopAttacks(to, occupied) & bishopsQueens;
+        }
+        if (type == PieceType::ROOK || type == PieceType::QUEEN) {
+            attackers |= attacks::rookAttacks(to, occupied) & rooksQueens;
+        }
+        attackers &= occupied;
+        
+        onSquare = Piece(type, side).getValue();
+        side = opposite(side);
+    }
+    
+    // each side only goes on capturing when that beats stopping
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    
+    return gain[0];
+}
+
+Bitboard Board::getPinnedPieces(Color color) const {
+    Bitboard king = getPieces(PieceType::KING, color);
+    if (!king) {
+        return 0;
+    }
+    
+    int kingSquare = lsb(king);
+    Color them = opposite(color);
+    Bitboard occupied = getOccupied();
+    Bitboard pinned = 0;
+    
+    // enemy sliders that would hit the king on an empty board
+    Bitboard snipers = (attacks::rookAttacks(kingSquare, 0) &
+                        (getPieces(PieceType::ROOK, them) | getPieces(PieceType::QUEEN, them))) |
+                       (attacks::bishopAttacks(kingSquare, 0) &
+                        (getPieces(PieceType::BISHOP, them) | getPieces(PieceType::QUEEN, them)));
+    
+    // a lone piece of ours in between is pinned
+    while (snipers) {
+        Bitboard blockers = attacks::between(kingSquare, popLsb(snipers)) & occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & getPieces(color))) {
+            pinned |= blockers;
+        }
+    }
+    
+    return pinned;
+}
+
+MoveList Board::generateLegalMoves(MoveGenType type) const {
+    MoveList moves;
+    
+    Color us = sideToMove;
+    Color them = opposite(us);
+    Bitboard own = getPieces(us);
+    Bitboard enemies = getPieces(them);
+    Bitboard occupied = own | enemies;
+    Bitboard king = getPieces(PieceType::KING, us);
+    int kingSquare = king ? lsb(king) : -1;
+    
+    // squares the other pieces may move to, narrowed down when in check
+    Bitboard targetMask = ~own;
+    Bitboard pinned = 0;
+    
+    // captures land on enemies, quiets anywhere else (pawns are sorted out separately)
+    Bitboard typeMask = type == MoveGenType::CAPTURES ? enemies :
+                        type == MoveGenType::QUIETS ? ~enemies : ~0ULL;
+    
+    if (king) {
+        Bitboard checkers = getAttackers(kingSquare, occupied) & enemies;
+        
+        // king moves, with the king taken off the board so it can't hide behind itself
+        Bitboard targets = attacks::kingAttacks(kingSquare) & ~own & typeMask;
+        while (targets) {
+            int to = popLsb(targets);
+            if (!(getAttackers(to, occupied ^ king) & enemies)) {
+                moves.push_back(Move(kingSquare, to));
+            }
+        }
+        
+        // double check, only the king can move
+        if (checkers & (checkers - 1)) {
+            return moves;
+        }
+        
+        // single check, capture the checker or block it
+        if (checkers) {
+            targetMask &= attacks::between(kingSquare, lsb(checkers)) | checkers;
+        }
+        
+        // castling, never out of check and never through or into an attacked square
+        if (!checkers && type != MoveGenType::CAPTURES) {
+            for (const CastlingMove& castling : castlingMoves) {
+                if (!(castlingRights & castling.right) || castling.kingFrom != kingSquare ||
+                    !(getPieces(PieceType::ROOK, us) & squareBB(castling.rookFrom)) ||
+                    (attacks::between(castling.kingFrom, castling.rookFrom) & occupied)) {
+                    continue;
+                }
                 
-                // filter out moves that would leave the king in check
-                for (const Move& move : pieceMoves) {
-                    // make a copy of the board
-                    Board testBoard = *this;
-                    
-                    // make the move on the copy
-                    testBoard.setPiece(move.to, piece);
-                    testBoard.setPiece(move.from, Piece());
-                    
-                    // handle pawn promotion
-                    if (piece.getType() == PieceType::PAWN && 
-                        ((sideToMove == Color::WHITE && move.to.rank == 7) || 
-                         (sideToMove == Color::BLACK && move.to.rank == 0))) {
-                        if (move.promotion != PieceType::EMPTY) {
-                            testBoard.setPiece(move.to, Piece(move.promotion, sideToMove));
-                        } else {
-                            // default promotion to queen idc man
-                            testBoard.setPiece(move.to, Piece(PieceType::QUEEN, sideToMove));
-                        }
-                    }
-                    
-                    // find the king on the test board
-                    Position kingPos(-1, -1);
-                    for (int r = 0; r < 8; r++) {
-                        for (int f = 0; f < 8; f++) {
-                            Piece p = testBoard.getPiece(Position(f, r));
-                            if (!p.isEmpty() && p.getType() == PieceType::KING && 
-                                p.getColor() == sideToMove) {
-                                kingPos = Position(f, r);
-                                break;
-                            }
-                        }
-                        if (kingPos.isValid()) {
-                            break;
-                        }
-                    }
-                    
-                    // check if the king is under attack after the move
-                    if (!kingPos.isValid() || 
-                        !testBoard.isUnderAttack(kingPos, (sideToMove == Color::WHITE) ? Color::BLACK : Color::WHITE)) {
-                        legalMoves.push_back(move);
-                    }
+                Bitboard path = attacks::between(castling.kingFrom, castling.kingTo) | squareBB(castling.kingTo);
+                bool pathAttacked = false;
+                while (path && !pathAttacked) {
+                    pathAttacked = (getAttackers(popLsb(path), occupied ^ king) & enemies) != 0;
                 }
+                
+                if (!pathAttacked) {
+                    moves.push_back(Move(castling.kingFrom, castling.kingTo, Move::CASTLING));
+                }
+            }
+        }
+        
+        pinned = getPinnedPieces(us);
+    }
+    
+    // knights (a pinned knight can never move)
+    Bitboard knights = getPieces(PieceType::KNIGHT, us) & ~pinned;
+    while (knights) {
+        int from = popLsb(knights);
+        addMoves(from, attacks::knightAttacks(from) & targetMask & typeMask, moves);
+    }
+    
+    // sliders, pinned ones can only move along the pin
+    Bitboard sliders = getPieces(PieceType::BISHOP, us) | getPieces(PieceType::ROOK, us) |
+                       getPieces(PieceType::QUEEN, us);
+    while (sliders) {
+        int from = popLsb(sliders);
+        Bitboard targets;
+        switch (mailbox[from].getType()) {
+            case PieceType::BISHOP: targets = attacks::bishopAttacks(from, occupied); break;
+            case PieceType::ROOK:   targets = attacks::rookAttacks(from, occupied); break;
+            default:                targets = attacks::queenAttacks(from, occupied); break;
+        }
+        
+        targets &= targetMask & typeMask;
+        if (pinned & squareBB(from)) {
+            targets &= attacks::line(kingSquare, from);
+        }
+        
+        addMoves(from, targets, moves);
+    }
+    
+    // pawns
+    int forward = (us == Color::WHITE) ? 8 : -8;
+    Bitboard startRank = rankBB((us == Color::WHITE) ? 1 : 6);
+    Bitboard promotionRank = rankBB((us == Color::WHITE) ? 7 : 0);
+    int epSquare = enPassantTarget.isValid() ? enPassantTarget.toIndex() : -1;
+    
+    Bitboard pawns = getPieces(PieceType::PAWN, us);
+    while (pawns) {
+        int from = popLsb(pawns);
+        
+        Bitboard targets = attacks::pawnAttacks(us, from) & enemies;
+        
+        // forward move, double forward move from starting position
+        int push = from + forward;
+        if (!(occupied & squareBB(push))) {
+            targets |= squareBB(push);
+            if ((startRank & squareBB(from)) && !(occupied & squareBB(push + forward))) {
+                targets |= squareBB(push + forward);
+            }
+        }
+        
+        targets &= targetMask;
+        if (pinned & squareBB(from)) {
+            targets &= attacks::line(kingSquare, from);
+        }
+        
+        // promotions count as captures even when they are pushes
+        if (type == MoveGenType::CAPTURES) {
+            targets &= enemies | promotionRank;
+        } else if (type == MoveGenType::QUIETS) {
+            targets &= ~enemies & ~promotionRank;
+        }
+        
+        while (targets) {
+            int to = popLsb(targets);
+            
+            // check for promotion
+            if (promotionRank & squareBB(to)) {
+                moves.push_back(Move(from, to, Move::PROMOTION, PieceType::QUEEN));
+                moves.push_back(Move(from, to, Move::PROMOTION, PieceType::ROOK));
+                moves.push_back(Move(from, to, Move::PROMOTION, PieceType::BISHOP));
+                moves.push_back(Move(from, to, Move::PROMOTION, PieceType::KNIGHT));
+            } else {
+                moves.push_back(Move(from, to));
+            }
+        }
+        
+        // en passant removes two pawns from their squares at once, so rather than reasoning
+        // about pins and evasions we play it on the occupancy and look at the king
+        if (epSquare >= 0 && type != MoveGenType::QUIETS && (attacks::pawnAttacks(us, from) & squareBB(epSquare))) {
+            int capturedSquare = epSquare - forward;
+            if (!(getPieces(PieceType::PAWN, them) & squareBB(capturedSquare))) {
+                continue;
+            }
+            
+            Bitboard after = (occupied ^ squareBB(from) ^ squareBB(capturedSquare)) | squareBB(epSquare);
+            if (!king || !(getAttackers(kingSquare, after) & enemies & ~squareBB(capturedSquare))) {
+                moves.push_back(Move(from, epSquare, Move::EN_PASSANT));
             }
         }
     }
     
-    return legalMoves;
+    return moves;
 }
 
-std::vector<Move> Board::generatePseudoLegalMoves(const Position& pos) const {
-    std::vector<Move> moves;
+MoveList Board::generatePseudoLegalMoves(const Position& pos) const {
+    MoveList moves;
     Piece piece = getPiece(pos);
     
     if (piece.isEmpty() || piece.getColor() != sideToMove) {
         return moves;
     }
     
-    switch (piece.getType()) {
+    generatePieceMoves(pos, moves);
+    return moves;
+}
+
+void Board::generatePieceMoves(const Position& pos, MoveList& moves) const {
+    switch (getPiece(pos).getType()) {
         case PieceType::PAWN:
             generatePawnMoves(pos, moves);
             break;
@@ -270,18 +564,11 @@ std::vector<Move> Board::generatePseudoLegalMoves(const Position& pos) const {
         default:
             break;
     }
-    
-    return moves;
 }
 
 bool Board::isLegalMove(const Move& move) const {
-    // check if the move is valid
-    if (!move.from.isValid() || !move.to.isValid()) {
-        return false;
-    }
-    
     // get the piece at the from position
-    Piece piece = getPiece(move.from);
+    Piece piece = getPiece(move.from());
     
     // check if there is a piece at the from position and it's the correct color
     if (piece.isEmpty() || piece.getColor() != sideToMove) {
@@ -289,11 +576,44 @@ bool Board::isLegalMove(const Move& move) const {
     }
     
     // get all legal moves for this piece
-    std::vector<Move> legalMoves = generateLegalMoves();
+    MoveList legalMoves = generateLegalMoves();
     
     // check if the move is in the list of legal moves
     for (const Move& legalMove : legalMoves) {
-        if (legalMove.from == move.from && legalMove.to == move.to) {
+        if (legalMove.fromSquare() == move.fromSquare() && legalMove.toSquare() == move.toSquare()) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool Board::hasInsufficientMaterial() const {
+    // any pawn, rook or queen can still mate
+    if (getPieces(PieceType::PAWN) | getPieces(PieceType::ROOK) | getPieces(PieceType::QUEEN)) {
+        return false;
+    }
+    
+    // bare kings or a single minor piece
+    Bitboard minors = getPieces(PieceType::KNIGHT) | getPieces(PieceType::BISHOP);
+    if (popCount(minors) <= 1) {
+        return true;
+    }
+    
+    // only bishops, all on the same square color
+    const Bitboard darkSquares = 0xAA55AA55AA55AA55ULL;
+    Bitboard bishops = getPieces(PieceType::BISHOP);
+    return !getPieces(PieceType::KNIGHT) && (!(bishops & darkSquares) || !(bishops & ~darkSquares));
+}
+
+bool Board::isRepetition(int times) const {
+    // only positions since the last capture or pawn move can repeat, and only every other ply
+    int size = static_cast<int>(undoStack.size());
+    int limit = std::min(halfMoveClock, size);
+    int found = 0;
+    
+    for (int ply = 4; ply <= limit; ply += 2) {
+        if (undoStack[size - ply].hash == key && ++found >= times) {
             return true;
         }
     }
@@ -301,7 +621,45 @@ bool Board::isLegalMove(const Move& move) const {
     return false;
 }
 
-void Board::generatePawnMoves(const Position& pos, std::vector<Move>& moves) const {
+bool Board::isDraw() const {
+    return isFiftyMoveDraw() || hasInsufficientMaterial() || isRepetition(2);
+}
+
+uint64_t Board::perft(int depth) {
+    if (depth <= 0) {
+        return 1;
+    }
+    
+    MoveList moves = generateLegalMoves();
+    
+    // every legal move is a leaf, no need to play them (bulk counting)
+    if (depth == 1) {
+        return moves.size();
+    }
+    
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        makeMoveUnchecked(move);
+        nodes += perft(depth - 1);
+        unmakeMove();
+    }
+    
+    return nodes;
+}
+
+std::vector<std::pair<Move, uint64_t>> Board::divide(int depth) {
+    std::vector<std::pair<Move, uint64_t>> result;
+    
+    for (const Move& move : generateLegalMoves()) {
+        makeMoveUnchecked(move);
+        result.push_back({move, perft(depth - 1)});
+        unmakeMove();
+    }
+    
+    return result;
+}
+
+void Board::generatePawnMoves(const Position& pos, MoveList& moves) const {
     Piece pawn = getPiece(pos);
     if (pawn.isEmpty() || pawn.getType() != PieceType::PAWN) {
         return;
@@ -353,96 +711,39 @@ void Board::generatePawnMoves(const Position& pos, std::vector<Move>& moves) con
     }
 }
 
-void Board::generateKnightMoves(const Position& pos, std::vector<Move>& moves) const {
-    Piece knight = getPiece(pos);
-    if (knight.isEmpty() || knight.getType() != PieceType::KNIGHT) {
-        return;
-    }
-    
-    const std::vector<std::pair<int, int>> knightMoves = {
-        {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}
-    };
-    
-    for (const auto& move : knightMoves) {
-        Position target(pos.file + move.first, pos.rank + move.second);
-        if (target.isValid()) {
-            Piece targetPiece = getPiece(target);
-            if (targetPiece.isEmpty() || targetPiece.getColor() != knight.getColor()) {
-                moves.push_back(Move(pos, target));
-            }
-        }
-    }
+void Board::generateKnightMoves(const Position& pos, MoveList& moves) const {
+    addMoves(pos, attacks::knightAttacks(pos.toIndex()), moves);
 }
 
-void Board::generateBishopMoves(const Position& pos, std::vector<Move>& moves) const {
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
-    };
-    
-    generateSlidingMoves(pos, directions, moves);
+void Board::generateBishopMoves(const Position& pos, MoveList& moves) const {
+    addMoves(pos, attacks::bishopAttacks(pos.toIndex(), getOccupied()), moves);
 }
 
-void Board::generateRookMoves(const Position& pos, std::vector<Move>& moves) const {
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, 0}, {1, 0}, {0, -1}, {0, 1}
-    };
-    
-    generateSlidingMoves(pos, directions, moves);
+void Board::generateRookMoves(const Position& pos, MoveList& moves) const {
+    addMoves(pos, attacks::rookAttacks(pos.toIndex(), getOccupied()), moves);
 }
 
-void Board::generateQueenMoves(const Position& pos, std::vector<Move>& moves) const {
-    const std::vector<std::pair<int, int>> directions = {
-        {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
-    };
-    
-    generateSlidingMoves(pos, directions, moves);
+void Board::generateQueenMoves(const Position& pos, MoveList& moves) const {
+    addMoves(pos, attacks::queenAttacks(pos.toIndex(), getOccupied()), moves);
 }
 
-void Board::generateKingMoves(const Position& pos, std::vector<Move>& moves) const {
-    Piece king = getPiece(pos);
-    if (king.isEmpty() || king.getType() != PieceType::KING) {
-        return;
-    }
-    
-    const std::vector<std::pair<int, int>> kingMoves = {
-        {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
-    };
-    
-    for (const auto& move : kingMoves) {
-        Position target(pos.file + move.first, pos.rank + move.second);
-        if (target.isValid()) {
-            Piece targetPiece = getPiece(target);
-            if (targetPiece.isEmpty() || targetPiece.getColor() != king.getColor()) {
-                moves.push_back(Move(pos, target));
-            }
-        }
-    }
+void Board::generateKingMoves(const Position& pos, MoveList& moves) const {
+    addMoves(pos, attacks::kingAttacks(pos.toIndex()), moves);
 }
 
-void Board::generateSlidingMoves(const Position& pos, const std::vector<std::pair<int, int>>& directions, 
-                                std::vector<Move>& moves) const {
+void Board::addMoves(const Position& pos, Bitboard targets, MoveList& moves) const {
     Piece piece = getPiece(pos);
     if (piece.isEmpty()) {
         return;
     }
     
-    for (const auto& dir : directions) {
-        for (int i = 1; i < 8; i++) {
-            Position target(pos.file + i * dir.first, pos.rank + i * dir.second);
-            if (!target.isValid()) {
-                break;
-            }
-            
-            Piece targetPiece = getPiece(target);
-            if (targetPiece.isEmpty()) {
-                moves.push_back(Move(pos, target));
-            } else {
-                if (targetPiece.getColor() != piece.getColor()) {
-                    moves.push_back(Move(pos, target));
-                }
-                break;
-            }
-        }
+    // can't capture our own pieces
+    addMoves(pos.toIndex(), targets & ~getPieces(piece.getColor()), moves);
+}
+
+void Board::addMoves(int from, Bitboard targets, MoveList& moves) const {
+    while (targets) {
+        moves.push_back(Move(from, popLsb(targets)));
     }
 }
 
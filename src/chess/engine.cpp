@@ -1,127 +1,676 @@
 #include "chess/engine.h"
 #include <algorithm>
-#include <iostream>
+#include <array>
+#include <cmath>
 
 namespace chess {
 
+namespace {
+
+constexpr int INFINITE_SCORE = 30000;
+constexpr int MATE_SCORE = 20000;
+constexpr int MATE_BOUND = MATE_SCORE - 1000;   // anything beyond this is a mate score
+constexpr int ASPIRATION_WINDOW = 30;           // initial half-width of the root window
+constexpr int DELTA_MARGIN = 200;               // slack for positional gains in quiescence delta pruning
+constexpr int RFP_DEPTH = 6;                    // reverse futility pruning up to this depth
+constexpr int RFP_MARGIN = 80;                  // ... when the eval beats beta by this much per ply
+constexpr int FUTILITY_DEPTH = 3;               // futility pruning of quiets up to this depth
+constexpr int FUTILITY_MARGIN = 120;            // ... when the eval plus this much per ply can't reach alpha
+
+// mate scores count plies from the root, the table stores them counted from the node instead
+int scoreToTT(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Lazy SMP depth staggering: helper i skips depth d when ((d + phase) / size) is odd, so
+// the helpers spread over neighbouring depths instead of all searching the same one
+constexpr int skipSize[20]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int skipPhase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// late move reduction in plies, growing with both depth and how late the move comes
+int lmrReduction(int depth, int moveCount) {
+    static const auto table = [] {
+        std::array<std::array<int, 64>, 64> reductions{};
+        for (int d = 1; d < 64; d++) {
+            for (int m = 1; m < 64; m++) {
+                reductions[d][m] = static_cast<int>(0.75 + std::log(d) * std::log(m) / 2.25);
+            }
+        }
+        return reductions;
+    }();
+    
+    return table[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+} // anonymous namespace
+
+Engine::Engine(int depth)
+    : maxDepth(depth), depthLimit(0), softTimeLimit(0), hardTimeLimit(0), stopSearch(false),
+      searchGeneration(0), helpersRunning(0), quitting(false), searching(false) {
+    setThreads(1);
+}
+
+Engine::~Engine() {
+    stop();
+    waitForSearch();
+    stopHelpers();
+}
+
+void Engine::clearHistory() {
+    for (auto& worker : workers) {
+        worker->history.clear();
+        for (auto& plyKillers : worker->killers) {
+            plyKillers[0] = plyKillers[1] = Move();
+        }
+    }
+}
+
+void Engine::setThreads(int count) {
+    count = std::max(count, 1);
+    stopHelpers();
+    
+    // existing workers keep their history
+    while (static_cast<int>(workers.size()) > count) {
+        workers.pop_back();
+    }
+    while (static_cast<int>(workers.size()) < count) {
+        workers.push_back(std::unique_ptr<SearchWorker>(new SearchWorker(*this, static_cast<int>(workers.size()))));
+    }
+    
+    for (int id = 1; id < count; id++) {
+        helperThreads.emplace_back(&Engine::helperLoop, this, id, searchGeneration);
+    }
+}
+
+void Engine::stopHelpers() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        quitting = true;
+    }
+    poolCondition.notify_all();
+    
+    for (std::thread& thread : helperThreads) {
+        thread.join();
+    }
+    helperThreads.clear();
+    quitting = false;
+}
+
+void Engine::helperLoop(int id, uint64_t lastGeneration) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    
+    while (true) {
+        poolCondition.wait(lock, [&] { return quitting || searchGeneration != lastGeneration; });
+        if (quitting) {
+            return;
+        }
+        lastGeneration = searchGeneration;
+        
+        lock.unlock();
+        workers[id]->iterate();
+        lock.lock();
+        
+        if (--helpersRunning == 0) {
+            poolCondition.notify_all();
+        }
+    }
+}
+
+uint64_t Engine::getNodesSearched() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers) {
+        total += worker->getNodes();
+    }
+    return total;
+}
+
+void Engine::resetNodesSearched() {
+    for (auto& worker : workers) {
+        worker->nodes.store(0, std::memory_order_relaxed);
+    }
+}
+
 Move Engine::getBestMove(const Board& board) {
+    SearchLimits depthOnly;
+    depthOnly.depth = maxDepth;
+    return search(board, depthOnly);
+}
+
+int64_t Engine::getElapsedTime() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Engine::allocateTime(Color side) {
+    softTimeLimit = 0;
+    hardTimeLimit = 0;
+    
+    if (limits.infinite) {
+        return;
+    }
+    
+    // a fixed move time is meant to be used up, only the hard limit applies
+    if (limits.movetime > 0) {
+        hardTimeLimit = limits.movetime;
+        return;
+    }
+    
+    int64_t timeLeft = side == Color::WHITE ? limits.wtime : limits.btime;
+    int64_t increment = side == Color::WHITE ? limits.winc : limits.binc;
+    if (timeLeft <= 0) {
+        return;
+    }
+    
+    // keep a little back for move overhead, then spread the rest over the moves still to play
+    const int64_t overhead = 20;
+    int64_t usable = std::max<int64_t>(timeLeft - overhead, 1);
+    int movesLeft = limits.movestogo > 0 ? std::min(limits.movestogo, 40) : 30;
+    
+    softTimeLimit = std::min(usable / movesLeft + increment * 3 / 4, usable);
+    hardTimeLimit = std::min(softTimeLimit * 4, usable / 2 + increment);
+    hardTimeLimit = std::max(std::min(hardTimeLimit, usable), softTimeLimit);
+}
+
+void Engine::checkLimits() {
+    if ((limits.nodes > 0 && getNodesSearched() >= limits.nodes) ||
+        (hardTimeLimit > 0 && getElapsedTime() >= hardTimeLimit)) {
+        stopSearch = true;
+    }
+}
+
+Move Engine::search(const Board& board, const SearchLimits& searchLimits) {
+    stopSearch = false;
+    return runSearch(board, searchLimits);
+}
+
+void Engine::startSearch(const Board& board, const SearchLimits& searchLimits,
+                         std::function<void(Move)> onDone) {
+    waitForSearch();
+    
+    // cleared here rather than on the search thread, so a stop() sent right after can't be undone
+    stopSearch = false;
+    searching = true;
+    searchThread = std::thread([this, board, searchLimits, onDone] {
+        asyncBestMove = runSearch(board, searchLimits);
+        searching = false;
+        if (onDone) {
+            onDone(asyncBestMove);
+        }
+    });
+}
+
+Move Engine::waitForSearch() {
+    if (searchThread.joinable()) {
+        searchThread.join();
+    }
+    return asyncBestMove;
+}
+
+Move Engine::runSearch(const Board& board, const SearchLimits& searchLimits) {
     // reset the node counter
     resetNodesSearched();
     
     // start the timer
     startTime = std::chrono::steady_clock::now();
+    limits = searchLimits;
+    allocateTime(board.getSideToMove());
     
     // get all legal moves
-    std::vector<Move> legalMoves = board.generateLegalMoves();
+    MoveList legalMoves = board.generateLegalMoves();
     
     if (legalMoves.empty()) {
         return Move(); // no legal moves
     }
     
-    Move bestMove = legalMoves[0];
-    int bestScore = (board.getSideToMove() == Color::WHITE) ? 
-                    std::numeric_limits<int>::min() : 
-                    std::numeric_limits<int>::max();
+    // results from earlier searches stay usable, but get replaced first
+    tt.newSearch();
+    
+    // wake the helpers, then search on this thread as the main worker
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        root = board;
+        rootMoves = legalMoves;
+        depthLimit = limits.depth > 0 ? std::min(limits.depth, static_cast<int>(MAX_DEPTH)) : MAX_DEPTH;
+        helpersRunning = static_cast<int>(helperThreads.size());
+        searchGeneration++;
+    }
+    poolCondition.notify_all();
     
-    // evaluate each move
-    for (const Move& move : legalMoves) {
-        // make a copy of the board
-        Board testBoard = board;
+    SearchWorker& main = *workers[0];
+    main.iterate();
+    
+    // an infinite search only ends when it's told to, even if it ran out of depth first
+    while (limits.infinite && !stopSearch) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    // the main thread decides when we're done, the helpers just stop with it
+    stopSearch = true;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolCondition.wait(lock, [&] { return helpersRunning == 0; });
+    }
+    
+    return main.bestLine.empty() ? legalMoves[0] : main.bestLine[0];
+}
+
+SearchWorker::SearchWorker(Engine& engine, int id)
+    : engine(engine), id(id), nodes(0), rootDepth(0), completedDepth(0), bestScore(0), pvLength() {
+}
+
+void SearchWorker::countNode() {
+    // only the owner writes the counter, other threads just read it
+    uint64_t count = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(count, std::memory_order_relaxed);
+    
+    if (id == 0 && (count & 2047) == 0) {
+        engine.checkLimits();
+    }
+}
+
+bool SearchWorker::stopping() const {
+    // depth 1 always finishes, so there is a move to play however soon we're stopped
+    return rootDepth > 1 && engine.stopSearch.load(std::memory_order_relaxed);
+}
+
+void SearchWorker::iterate() {
+    // one working copy for the whole search, moves are made and taken back on it
+    board = engine.root;
+    completedDepth = 0;
+    bestScore = 0;
+    bestLine.clear();
+    for (auto& plyKillers : killers) {
+        plyKillers[0] = plyKillers[1] = Move();
+    }
+    
+    for (rootDepth = 1; rootDepth <= engine.depthLimit; rootDepth++) {
+        // helpers skip some depths so they don't all search the same tree as the main thread
+        if (id > 0) {
+            int i = (id - 1) % 20;
+            if (((rootDepth + skipPhase[i]) / skipSize[i]) % 2) {
+                continue;
+            }
+        }
         
-        // make the move
-        testBoard.makeMove(move);
+        // aspiration window: expect a score close to the last one and widen it whenever
+        // the search falls outside, a narrow window cuts a lot more
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if (rootDepth >= 4) {
+            alpha = std::max(bestScore - delta, -INFINITE_SCORE);
+            beta = std::min(bestScore + delta, INFINITE_SCORE);
+        }
         
-        // evaluate the position using minimax
-        int score = minimax(testBoard, maxDepth - 1, 
-                           std::numeric_limits<int>::min(), 
-                           std::numeric_limits<int>::max(), 
-                           board.getSideToMove() != Color::WHITE);
+        int score;
+        while (true) {
+            score = negamax(rootDepth, 0, alpha, beta);
+            if (stopping()) {
+                break;
+            }
+            
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, INFINITE_SCORE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
         
-        // Update the best move
-        if ((board.getSideToMove() == Color::WHITE && score > bestScore) ||
-            (board.getSideToMove() == Color::BLACK && score < bestScore)) {
-            bestScore = score;
-            bestMove = move;
+        // an aborted iteration didn't look at every move, so it can't be trusted
+        if (stopping()) {
+            break;
+        }
+        
+        completedDepth = rootDepth;
+        bestScore = score;
+        if (pvLength[0] > 0) {
+            bestLine.assign(pvTable[0], pvTable[0] + pvLength[0]);
+        }
+        
+        // the rest is the main thread's job
+        if (id != 0) {
+            if (engine.stopSearch.load(std::memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        
+        if (engine.infoCallback) {
+            SearchInfo info;
+            info.depth = rootDepth;
+            info.score = bestScore;
+            info.mate = 0;
+            if (bestScore > MATE_BOUND) {
+                info.mate = (MATE_SCORE - bestScore + 1) / 2;
+            } else if (bestScore < -MATE_BOUND) {
+                info.mate = -(MATE_SCORE + bestScore + 1) / 2;
+            }
+            info.nodes = engine.getNodesSearched();
+            info.time = engine.getElapsedTime();
+            info.hashfull = engine.tt.hashfull();
+            info.bestMove = bestLine.empty() ? Move() : bestLine[0];
+            info.pv = bestLine;
+            engine.infoCallback(info);
+        }
+        
+        // with a single legal move there is nothing to think about on the clock
+        if (engine.hardTimeLimit > 0 && engine.rootMoves.size() == 1) {
+            break;
+        }
+        
+        // the next iteration takes a few times longer than this one, so past half the target
+        // it would most likely be aborted anyway
+        if (engine.softTimeLimit > 0 && engine.getElapsedTime() >= engine.softTimeLimit / 2) {
+            break;
+        }
+        engine.checkLimits();
+        if (engine.stopSearch) {
+            break;
         }
     }
-    
-    // Calculate search time
-    auto endTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
-    
-    std::cout << "Nodes searched: " << nodesSearched << std::endl;
-    std::cout << "Time taken: " << duration << " ms" << std::endl;
-    std::cout << "Best move: " << bestMove.toAlgebraic() << " with score: " << bestScore << std::endl;
-    
-    return bestMove;
 }
 
-int Engine::minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer) {
-    // increment the node counter
-    nodesSearched++;
+int SearchWorker::negamax(int depth, int ply, int alpha, int beta) {
+    // increment the node counter, and every so often see if we have to stop
+    countNode();
+    if (stopping()) {
+        return 0;
+    }
+    
+    pvLength[ply] = 0;
+    bool rootNode = ply == 0;
+    bool pvNode = beta - alpha > 1;
     
-    // base case: leaf node or terminal position
-    if (depth == 0) {
-        return evaluator.evaluate(board);
+    // draw by rule or by repeating a position from earlier in the game or search
+    // (the root still has to come up with a move)
+    if (!rootNode && (board.isDraw() || board.isRepetition())) {
+        return 0;
     }
     
-    std::vector<Move> legalMoves = board.generateLegalMoves();
+    // base case: resolve the captures before trusting the evaluation
+    if (depth <= 0) {
+        return quiescence(ply, alpha, beta);
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluate();
+    }
     
-    // check for checkmate or stalemate
-    if (legalMoves.empty()) {
-        if (board.isInCheck()) {
-            // checkmate (worst possible score, but adjusted for depth)
-            return maximizingPlayer ? -20000 + (maxDepth - depth) : 20000 - (maxDepth - depth);
-        } else {
-            // stalemate (draw)
-            return 0;
+    // reuse what we already know about this position, PV nodes keep searching so the
+    // line they report stays complete
+    TTEntry entry;
+    Move ttMove;
+    if (engine.tt.probe(board.hash(), entry)) {
+        ttMove = entry.move;
+        
+        if (!pvNode && entry.depth >= depth) {
+            int score = scoreFromTT(entry.score, ply);
+            if (entry.bound == Bound::EXACT ||
+                (entry.bound == Bound::LOWER && score >= beta) ||
+                (entry.bound == Bound::UPPER && score <= alpha)) {
+                return score;
+            }
         }
     }
     
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
+    Color us = board.getSideToMove();
+    bool inCheck = board.isInCheck();
+    int staticEval = inCheck ? -INFINITE_SCORE : evaluate();
+    
+    if (!pvNode && !inCheck && std::abs(beta) < MATE_BOUND) {
+        // reverse futility pruning: so far above beta that a shallow search won't bring it back
+        if (depth <= RFP_DEPTH && staticEval - RFP_MARGIN * depth >= beta) {
+            return staticEval;
+        }
         
-        for (const Move& move : legalMoves) {
-            // make a copy of the board
-            Board testBoard = board;
+        // null move pruning: if we're still above beta after passing, a real move will be too.
+        // Not twice in a row, and not with only pawns left, where passing would often be the
+        // best move if it were allowed (zugzwang)
+        Bitboard pieces = board.getPieces(us) & ~board.getPieces(PieceType::PAWN) & ~board.getPieces(PieceType::KING);
+        if (depth >= 3 && staticEval >= beta && pieces && !board.getLastMove().isNull()) {
+            int reduction = 3 + depth / 6;
             
-            // make the move
-            testBoard.makeMove(move);
-            
-            // recursively evaluate the position
-            int eval = minimax(testBoard, depth - 1, alpha, beta, false);
-            maxEval = std::max(maxEval, eval);
+            board.makeNullMove();
+            int score = -negamax(depth - 1 - reduction, ply + 1, -beta, -beta + 1);
+            board.unmakeNullMove();
+            if (stopping()) {
+                return 0;
+            }
             
-            // alpha-beta pruning
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) {
-                break;
+            if (score >= beta) {
+                return score >= MATE_BOUND ? beta : score;
             }
         }
+    }
+    
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove;
+    int moveCount = 0;
+    
+    // quiets that didn't cut, they lose history if a later move does
+    MoveList quietsTried;
+    
+    MovePicker picker(board, ttMove, killers[ply], history);
+    for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+        bool quiet = !board.isCapture(move) && move.flag() != Move::PROMOTION;
+        
+        // futility pruning: close to the leaves a quiet move won't make up for being this far
+        // below alpha, unless it gives check
+        bool futile = !pvNode && !inCheck && quiet && moveCount > 0 && depth <= FUTILITY_DEPTH &&
+                      staticEval + FUTILITY_MARGIN * depth <= alpha && bestScore > -MATE_BOUND;
         
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
+        board.makeMoveUnchecked(move);
+        bool givesCheck = board.isInCheck();
+        if (futile && !givesCheck) {
+            board.unmakeMove();
+            continue;
+        }
+        moveCount++;
         
-        for (const Move& move : legalMoves) {
-            // make a copy of the board
-            Board testBoard = board;
+        // PVS: the first move gets the full window, the rest only have to be proven worse
+        // with a null window, and get a full re-search if that fails
+        int score;
+        if (moveCount == 1) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // late move reductions: quiet moves this far down the ordering rarely turn out best,
+            // so search them shallower first and only go full depth if they beat alpha
+            int reduction = 0;
+            if (depth >= 3 && moveCount > 3 && quiet && !inCheck && !givesCheck) {
+                reduction = lmrReduction(depth, moveCount);
+                reduction -= history.get(us, move) / (HistoryTable::MAX / 2);
+                if (pvNode || move == killers[ply][0] || move == killers[ply][1]) {
+                    reduction--;
+                }
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
             
-            // make the move
-            testBoard.makeMove(move);
+            score = -negamax(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction > 0 && score > alpha) {
+                score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        
+        board.unmakeMove();
+        if (stopping()) {
+            return 0;
+        }
+        
+        if (score > bestScore) {
+            bestScore = score;
             
-            // recursively evaluate the position :nerd:
-            int eval = minimax(testBoard, depth - 1, alpha, beta, true);
-            minEval = std::min(minEval, eval);
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                
+                // this move plus the line below it is the new principal variation
+                updatePV(ply, move);
+                
+                // beta cutoff, the opponent won't allow this line
+                if (alpha >= beta) {
+                    if (quiet) {
+                        updateQuietStats(us, move, ply, depth, quietsTried);
+                    }
+                    break;
+                }
+            }
+        }
+        
+        if (quiet) {
+            quietsTried.push_back(move);
+        }
+    }
+    
+    // no legal moves: checkmate is the worst possible score (but a later mate is less bad),
+    // stalemate is a draw
+    if (moveCount == 0) {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+    
+    Bound bound = bestScore >= beta ? Bound::LOWER :
+                  alpha > originalAlpha ? Bound::EXACT : Bound::UPPER;
+    engine.tt.store(board.hash(), bestMove, scoreToTT(bestScore, ply), depth, bound);
+    
+    return bestScore;
+}
+
+int SearchWorker::quiescence(int ply, int alpha, int beta) {
+    countNode();
+    if (stopping()) {
+        return 0;
+    }
+    
+    pvLength[ply] = 0;
+    bool pvNode = beta - alpha > 1;
+    
+    // captures reset the fifty move clock, so only running out of material can draw here
+    if (board.hasInsufficientMaterial()) {
+        return 0;
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluate();
+    }
+    
+    TTEntry entry;
+    Move ttMove;
+    if (engine.tt.probe(board.hash(), entry)) {
+        ttMove = entry.move;
+        
+        int score = scoreFromTT(entry.score, ply);
+        if (!pvNode && (entry.bound == Bound::EXACT ||
+                        (entry.bound == Bound::LOWER && score >= beta) ||
+                        (entry.bound == Bound::UPPER && score <= alpha))) {
+            return score;
+        }
+    }
+    
+    // stand pat: the side to move doesn't have to capture, so the static score is a lower
+    // bound, except in check where every evasion has to be looked at
+    bool inCheck = board.isInCheck();
+    int originalAlpha = alpha;
+    int standPat = -INFINITE_SCORE;
+    int bestScore = -INFINITE_SCORE;
+    
+    if (!inCheck) {
+        standPat = bestScore = evaluate();
+        if (standPat >= beta) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+    }
+    
+    Move bestMove;
+    int moveCount = 0;
+    
+    MovePicker picker = inCheck ? MovePicker(board, ttMove, nullptr, history)
+                                : MovePicker(board, ttMove, history);
+    for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+        moveCount++;
+        
+        if (!inCheck) {
+            // delta pruning: even winning the piece plus a margin can't lift the score to alpha
+            if (move.flag() != Move::PROMOTION) {
+                int captured = move.flag() == Move::EN_PASSANT ? Piece(PieceType::PAWN, Color::WHITE).getValue()
+                                                               : board.getPiece(move.to()).getValue();
+                if (standPat + captured + DELTA_MARGIN <= alpha) {
+                    continue;
+                }
+            }
             
-            // alpha-beta pruning (yup yup yup)
-            beta = std::min(beta, eval);
-            if (beta <= alpha) {
-                break;
+            // captures that lose material by exchange won't fix anything either
+            if (board.see(move) < 0) {
+                continue;
             }
         }
         
-        return minEval;
+        board.makeMoveUnchecked(move);
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        board.unmakeMove();
+        if (stopping()) {
+            return 0;
+        }
+        
+        if (score > bestScore) {
+            bestScore = score;
+            
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                
+                updatePV(ply, move);
+                
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    
+    // in check with no way out
+    if (inCheck && moveCount == 0) {
+        return -MATE_SCORE + ply;
+    }
+    
+    Bound bound = bestScore >= beta ? Bound::LOWER :
+                  alpha > originalAlpha ? Bound::EXACT : Bound::UPPER;
+    engine.tt.store(board.hash(), bestMove, scoreToTT(bestScore, ply), 0, bound);
+    
+    return bestScore;
+}
+
+void SearchWorker::updatePV(int ply, Move move) {
+    pvTable[ply][0] = move;
+    for (int i = 0; i < pvLength[ply + 1]; i++) {
+        pvTable[ply][i + 1] = pvTable[ply + 1][i];
+    }
+    pvLength[ply] = pvLength[ply + 1] + 1;
+}
+
+void SearchWorker::updateQuietStats(Color side, Move move, int ply, int depth, const MoveList& quietsTried) {
+    if (killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+    
+    int bonus = std::min(depth * depth * 16, HistoryTable::MAX);
+    history.update(side, move, bonus);
+    for (const Move& tried : quietsTried) {
+        history.update(side, tried, -bonus);
     }
 }
 
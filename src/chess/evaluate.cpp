@@ -1,87 +1,181 @@
 #include "chess/evaluate.h"
+#include "chess/attacks.h"
+#include "chess/psqt.h"
+#include <algorithm>
 
 namespace chess {
 
+namespace {
+
+// mobility: centipawns per square a piece can safely go to, counted from the number of
+// squares it has in a typical position so a normal piece scores around 0
+const int MOBILITY_WEIGHT[7] = {0, 0, 4, 4, 2, 1, 0};
+const int MOBILITY_BASE[7] = {0, 0, 4, 6, 7, 14, 0};
+
+// king safety: how dangerous each piece type is near the king, and how much of the total
+// counts depending on how many pieces join the attack (one piece alone is rarely a threat)
+const int KING_ATTACK_WEIGHT[7] = {0, 0, 2, 2, 3, 5, 0};
+const int KING_ATTACKER_SCALE[8] = {0, 0, 50, 75, 88, 94, 97, 99};
+const int KING_DANGER_UNIT = 20;
+const int MISSING_SHIELD_PAWN = 15;
+
+// pawn structure, midgame and endgame
+const psqt::Score DOUBLED_PAWN = {-10, -20};      // per extra pawn on a file
+const psqt::Score ISOLATED_PAWN = {-10, -15};     // no pawns of ours on the files next to it
+const psqt::Score BACKWARD_PAWN = {-8, -10};      // can't be supported and can't safely advance
+const psqt::Score SUPPORTED_PAWN = {8, 6};        // defended by one of our pawns (part of a chain)
+const psqt::Score PHALANX_PAWN = {5, 3};          // one of our pawns next to it on the same rank
+
+// passed pawns by rank counted from their own side
+const int PASSED_PAWN_MG[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+const int PASSED_PAWN_EG[8] = {0, 10, 20, 35, 60, 90, 130, 0};
+
+// the files next to a file
+Bitboard adjacentFiles(int file) {
+    return (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+}
+
+// all squares on ranks strictly in front of rank, seen from color's side
+Bitboard ranksAhead(Color color, int rank) {
+    if (color == Color::WHITE) {
+        return rank < 7 ? ~0ULL << (8 * (rank + 1)) : 0;
+    }
+    return (1ULL << (8 * rank)) - 1;
+}
+
+} // anonymous namespace
+
+Evaluator::Evaluator() : pawnTable(PAWN_TABLE_SIZE), evalCache(EVAL_CACHE_SIZE) {}
+
 int Evaluator::evaluate(const Board& board) const {
-    // start with material evaluation
-    int score = evaluateMaterial(board);
+    constexpr uint64_t SCORE_MASK = 0xFFFF;
+    
+    uint64_t key = board.hash();
+    uint64_t& entry = evalCache[key & (EVAL_CACHE_SIZE - 1)];
+    if (((entry ^ key) & ~SCORE_MASK) == 0) {
+        return static_cast<int16_t>(entry & SCORE_MASK);
+    }
+    
+    int score = evaluateTerms(board);
+    entry = (key & ~SCORE_MASK) | static_cast<uint16_t>(score);
+    return score;
+}
+
+int Evaluator::evaluateTerms(const Board& board) const {
+    // material and piece-square tables are kept up to date by the board as moves are made,
+    // blended between the midgame and endgame tables by how much material is left
+    int score = psqt::taper(board.getMidgameScore(), board.getEndgameScore(), board.getPhase());
+    
+    // every term that asks who attacks what shares one set of attack maps
+    AttackInfo attackInfo;
+    computeAttacks(board, attackInfo);
     
     // add center control evaluation
-    score += evaluateCenterControl(board);
+    score += evaluateCenterControl(board, attackInfo);
     
     // add other evaluation components
-    score += evaluatePiecePositions(board);
-    // score += evaluateMobility(board);
-    // score += evaluatePawnStructure(board);
-    // score += evaluateKingSafety(board);
+    score += evaluateMobility(attackInfo);
+    score += evaluatePawnStructure(board);
+    score += evaluateKingSafety(board, attackInfo);
     score += evaluateEarlyQueenDevelopment(board);
-    score += evaluatePieceDevelopment(board);
+    score += evaluatePieceDevelopment(board, attackInfo);
     score += evaluateEarlyKingMovement(board);
     score += evaluateCastling(board);
-    score += evaluatePawnDoubleMoves(board);
+    score += evaluatePawnDoubleMoves(board, attackInfo);
     
     return score;
 }
 
-int Evaluator::evaluateMaterial(const Board& board) const {
-    int score = 0;
-    
-    // material evaluation
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Piece piece = board.getPiece(Position(file, rank));
-            if (!piece.isEmpty()) {
-                int value = piece.getValue();
-                if (piece.getColor() == Color::BLACK) {
-                    value = -value;
-                }
-                score += value;
-            }
+void Evaluator::computeAttacks(const Board& board, AttackInfo& attackInfo) const {
+    Bitboard occupied = board.getOccupied();
+    
+    // pawns first, mobility below needs to know which squares the enemy pawns cover
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        int c = static_cast<int>(color);
+        Bitboard pawns = board.getPieces(PieceType::PAWN, color);
+        Bitboard left, right;
+        if (color == Color::WHITE) {
+            left = (pawns & ~fileBB(0)) << 7;
+            right = (pawns & ~fileBB(7)) << 9;
+        } else {
+            left = (pawns & ~fileBB(0)) >> 9;
+            right = (pawns & ~fileBB(7)) >> 7;
         }
+        
+        attackInfo.byType[c][static_cast<int>(PieceType::PAWN)] = left | right;
+        attackInfo.all[c] = left | right;
+        attackInfo.twice[c] = left & right;
     }
     
-    return score;
-}
-
-int Evaluator::evaluatePiecePositions(const Board& board) const {
-    int score = 0;
-    
-    // knight position evaluation - knights are better near the center
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        int c = static_cast<int>(color);
+        Color enemy = opposite(color);
+        Bitboard& all = attackInfo.all[c];
+        Bitboard& twice = attackInfo.twice[c];
+        int mobility = 0;
+        int kingAttackers = 0;
+        int kingAttackWeight = 0;
+        
+        // mobility only counts squares that aren't ours and aren't covered by an enemy pawn
+        Bitboard mobilityArea = ~board.getPieces(color) &
+                                ~attackInfo.byType[static_cast<int>(enemy)][static_cast<int>(PieceType::PAWN)];
+        
+        // the enemy king and the squares next to it
+        Bitboard enemyKing = board.getPieces(PieceType::KING, enemy);
+        Bitboard kingZone = enemyKing ? attacks::kingAttacks(lsb(enemyKing)) | enemyKing : 0;
+        
+        // record what one piece attacks
+        auto add = [&](PieceType type, Bitboard targets) {
+            int t = static_cast<int>(type);
+            attackInfo.byType[c][t] |= targets;
+            twice |= all & targets;
+            all |= targets;
             
-            // only evaluate knights
-            if (piece.getType() == PieceType::KNIGHT) {
-                // calculate distance from center (center is between d4, d5, e4, e5)
-                // file distance: how far from columns d and e (files 3,4)
-                int fileDistFromCenter = std::min(abs(file - 3), abs(file - 4));
-                // rank distance: how far from ranks 4 and 5 (ranks 3,4)
-                int rankDistFromCenter = std::min(abs(rank - 3), abs(rank - 4));
-                
-                // total Manhattan distance from center (its like the hypot but it sounds smart)
-                int distFromCenter = fileDistFromCenter + rankDistFromCenter;
-                
-                // knights get bonus points for being closer to center
-                // max bonus of 3 points for being in the center, decreasing as they move away
-                int positionBonus = 3 - distFromCenter;
-                if (positionBonus < 0) positionBonus = 0; // no penalty for being far
-                
-                // apply bonus based on piece color
-                if (piece.getColor() == Color::WHITE) {
-                    score += positionBonus;
-                } else {
-                    score -= positionBonus;
-                }
+            mobility += MOBILITY_WEIGHT[t] * (popCount(targets & mobilityArea) - MOBILITY_BASE[t]);
+            if (targets & kingZone) {
+                kingAttackers++;
+                kingAttackWeight += KING_ATTACK_WEIGHT[t] * popCount(targets & kingZone);
             }
+        };
+        
+        for (PieceType type : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN}) {
+            attackInfo.byType[c][static_cast<int>(type)] = 0;
+        }
+        
+        Bitboard pieces = board.getPieces(PieceType::KNIGHT, color);
+        while (pieces) {
+            add(PieceType::KNIGHT, attacks::knightAttacks(popLsb(pieces)));
         }
+        
+        pieces = board.getPieces(PieceType::BISHOP, color);
+        while (pieces) {
+            add(PieceType::BISHOP, attacks::bishopAttacks(popLsb(pieces), occupied));
+        }
+        
+        pieces = board.getPieces(PieceType::ROOK, color);
+        while (pieces) {
+            add(PieceType::ROOK, attacks::rookAttacks(popLsb(pieces), occupied));
+        }
+        
+        pieces = board.getPieces(PieceType::QUEEN, color);
+        while (pieces) {
+            add(PieceType::QUEEN, attacks::queenAttacks(popLsb(pieces), occupied));
+        }
+        
+        // the king attacks too, but doesn't count for mobility or king attacks
+        Bitboard king = board.getPieces(PieceType::KING, color);
+        Bitboard kingTargets = king ? attacks::kingAttacks(lsb(king)) : 0;
+        attackInfo.byType[c][static_cast<int>(PieceType::KING)] = kingTargets;
+        twice |= all & kingTargets;
+        all |= kingTargets;
+        
+        attackInfo.mobility[c] = mobility;
+        attackInfo.kingAttackers[c] = kingAttackers;
+        attackInfo.kingAttackWeight[c] = kingAttackWeight;
     }
-    
-    return score;
 }
 
-int Evaluator::evaluateCenterControl(const Board& board) const {
+int Evaluator::evaluateCenterControl(const Board& board, const AttackInfo& attackInfo) const {
     int score = 0;
     
     Position centerSquares[4] = {
@@ -106,7 +200,7 @@ int Evaluator::evaluateCenterControl(const Board& board) const {
             }
             
             // check if the piece is under attack
-            if (board.isUnderAttack(pos, piece.getColor() == Color::WHITE ? Color::BLACK : Color::WHITE)) {
+            if (attackInfo.isAttacked(pos, opposite(piece.getColor()))) {
                 // penalize if the piece is under attack
                 if (piece.getColor() == Color::WHITE) {
                     score -= 5;
@@ -120,12 +214,12 @@ int Evaluator::evaluateCenterControl(const Board& board) const {
     // bonus for attacking center squares
     for (const auto& pos : centerSquares) {
         // check white's control
-        if (board.isUnderAttack(pos, Color::WHITE)) {
+        if (attackInfo.isAttacked(pos, Color::WHITE)) {
             score += 5;
         }
         
         // check black's control
-        if (board.isUnderAttack(pos, Color::BLACK)) {
+        if (attackInfo.isAttacked(pos, Color::BLACK)) {
             score -= 5;
         }
     }
@@ -133,19 +227,125 @@ int Evaluator::evaluateCenterControl(const Board& board) const {
     return score;
 }
 
-int Evaluator::evaluateMobility(const Board& board) const {
-    // todo
-    return 0;
+int Evaluator::evaluateMobility(const AttackInfo& attackInfo) const {
+    return attackInfo.mobility[static_cast<int>(Color::WHITE)] - attackInfo.mobility[static_cast<int>(Color::BLACK)];
 }
 
 int Evaluator::evaluatePawnStructure(const Board& board) const {
-    // todo
-    return 0;
+    uint64_t key = board.pawnHash();
+    PawnEntry& entry = pawnTable[key & (PAWN_TABLE_SIZE - 1)];
+    
+    // a position without pawns has key 0, which matches the empty entries and scores 0 anyway
+    if (entry.key != key) {
+        scorePawns(board, entry);
+        entry.key = key;
+    }
+    
+    return psqt::taper(entry.mg, entry.eg, board.getPhase());
 }
 
-int Evaluator::evaluateKingSafety(const Board& board) const {
-    // todo
-    return 0;
+void Evaluator::scorePawns(const Board& board, PawnEntry& entry) const {
+    entry.mg = 0;
+    entry.eg = 0;
+    
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        Color enemy = opposite(color);
+        Bitboard ours = board.getPieces(PieceType::PAWN, color);
+        Bitboard theirs = board.getPieces(PieceType::PAWN, enemy);
+        int sign = (color == Color::WHITE) ? 1 : -1;
+        int forward = (color == Color::WHITE) ? 8 : -8;
+        int mg = 0;
+        int eg = 0;
+        
+        Bitboard pawns = ours;
+        while (pawns) {
+            int square = popLsb(pawns);
+            int file = square % 8;
+            int rank = square / 8;
+            int relativeRank = (color == Color::WHITE) ? rank : 7 - rank;
+            Bitboard neighbours = ours & adjacentFiles(file);
+            Bitboard ahead = ranksAhead(color, rank);
+            
+            // charge every pawn with another of ours in front of it, so each extra pawn counts once
+            bool doubled = ours & fileBB(file) & ahead;
+            if (doubled) {
+                mg += DOUBLED_PAWN.mg;
+                eg += DOUBLED_PAWN.eg;
+            }
+            
+            // passed: no enemy pawn in front of it on its own or the next files (and not stuck behind our own)
+            if (!doubled && !(theirs & (fileBB(file) | adjacentFiles(file)) & ahead)) {
+                mg += PASSED_PAWN_MG[relativeRank];
+                eg += PASSED_PAWN_EG[relativeRank];
+            }
+            
+            if (!neighbours) {
+                mg += ISOLATED_PAWN.mg;
+                eg += ISOLATED_PAWN.eg;
+            } else {
+                // backward: every neighbour is further up the board, and an enemy pawn guards the stop square
+                bool unsupported = !(neighbours & ~ahead);
+                int stop = square + forward;
+                if (unsupported && (attacks::pawnAttacks(color, stop) & theirs)) {
+                    mg += BACKWARD_PAWN.mg;
+                    eg += BACKWARD_PAWN.eg;
+                }
+            }
+            
+            // chains and pawns side by side
+            if (attacks::pawnAttacks(enemy, square) & ours) {
+                mg += SUPPORTED_PAWN.mg;
+                eg += SUPPORTED_PAWN.eg;
+            }
+            if (neighbours & rankBB(rank)) {
+                mg += PHALANX_PAWN.mg;
+                eg += PHALANX_PAWN.eg;
+            }
+        }
+        
+        entry.mg += sign * mg;
+        entry.eg += sign * eg;
+    }
+}
+
+int Evaluator::evaluateKingSafety(const Board& board, const AttackInfo& attackInfo) const {
+    int score = 0;
+    
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        Color enemy = opposite(color);
+        int e = static_cast<int>(enemy);
+        int danger = 0;
+        
+        // attacks on the squares around the king, worth more the more pieces take part
+        int attackers = std::min(attackInfo.kingAttackers[e], 7);
+        danger += attackInfo.kingAttackWeight[e] * KING_DANGER_UNIT * KING_ATTACKER_SCALE[attackers] / 100;
+        
+        // pawn shield: a pawn on each file around the king, one or two squares in front of it
+        Bitboard king = board.getPieces(PieceType::KING, color);
+        if (king) {
+            Position kingPos = Position::fromIndex(lsb(king));
+            int forward = (color == Color::WHITE) ? 1 : -1;
+            Bitboard shieldRanks = 0;
+            for (int step = 1; step <= 2; step++) {
+                int rank = kingPos.rank + step * forward;
+                if (rank >= 0 && rank < 8) {
+                    shieldRanks |= rankBB(rank);
+                }
+            }
+            
+            Bitboard pawns = board.getPieces(PieceType::PAWN, color);
+            for (int file = std::max(kingPos.file - 1, 0); file <= std::min(kingPos.file + 1, 7); file++) {
+                if (!(pawns & fileBB(file) & shieldRanks)) {
+                    danger += MISSING_SHIELD_PAWN;
+                }
+            }
+        }
+        
+        score += (color == Color::WHITE) ? -danger : danger;
+    }
+    
+    // the king only needs cover while there's enough material left to attack it
+    return score * std::min(board.getPhase(), psqt::MAX_PHASE) / psqt::MAX_PHASE;
 }
 
 int Evaluator::evaluateEarlyQueenDevelopment(const Board& board) const {
@@ -160,45 +360,42 @@ int Evaluator::evaluateEarlyQueenDevelopment(const Board& board) const {
     bool blackQueenFound = false;
     
     // scan the board to find the queens
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
+    Bitboard queens = board.getPieces(PieceType::QUEEN);
+    while (queens) {
+        Position pos = Position::fromIndex(popLsb(queens));
+        Piece piece = board.getPiece(pos);
+        
+        if (piece.getColor() == Color::WHITE) {
+            whiteQueenFound = true;
             
-            if (piece.getType() == PieceType::QUEEN) {
-                if (piece.getColor() == Color::WHITE) {
-                    whiteQueenFound = true;
-                    
-                    // if white queen is not on its starting square, apply penalty
-                    if (pos != whiteQueenStartPos) {
-                        // calculate manhattan distance from starting square
-                        int distance = abs(pos.file - whiteQueenStartPos.file) + 
-                                      abs(pos.rank - whiteQueenStartPos.rank);
-                        
-                        // Penalty is higher for moving the queen early
-                        // -15 points penalty for moving the queen
-                        score -= 15;
-                        
-                        // Additional penalty for moving it far from home
-                        score -= distance * 2;
-                    }
-                } else { // BLACK
-                    blackQueenFound = true;
-                    
-                    // if black queen is not on its starting square, apply penalty
-                    if (pos != blackQueenStartPos) {
-                        // calculate manhattan distance from starting square
-                        int distance = abs(pos.file - blackQueenStartPos.file) + 
-                                      abs(pos.rank - blackQueenStartPos.rank);
-                        
-                        // Penalty is higher for moving the queen early
-                        // +15 points penalty for moving the queen (positive for white's advantage)
-                        score += 15;
-                        
-                        // Additional penalty for moving it far from home
-                        score += distance * 2;
-                    }
-                }
+            // if white queen is not on its starting square, apply penalty
+            if (pos != whiteQueenStartPos) {
+                // calculate manhattan distance from starting square
+                int distance = abs(pos.file - whiteQueenStartPos.file) + 
+                              abs(pos.rank - whiteQueenStartPos.rank);
+                
+                // Penalty is higher for moving the queen early
+                // -15 points penalty for moving the queen
+                score -= 15;
+                
+                // Additional penalty for moving it far from home
+                score -= distance * 2;
+            }
+        } else { // BLACK
+            blackQueenFound = true;
+            
+            // if black queen is not on its starting square, apply penalty
+            if (pos != blackQueenStartPos) {
+                // calculate manhattan distance from starting square
+                int distance = abs(pos.file - blackQueenStartPos.file) + 
+                              abs(pos.rank - blackQueenStartPos.rank);
+                
+                // Penalty is higher for moving the queen early
+                // +15 points penalty for moving the queen (positive for white's advantage)
+                score += 15;
+                
+                // Additional penalty for moving it far from home
+                score += distance * 2;
             }
         }
     }
@@ -206,7 +403,7 @@ int Evaluator::evaluateEarlyQueenDevelopment(const Board& board) const {
     return score;
 }
 
-int Evaluator::evaluatePieceDevelopment(const Board& board) const {
+int Evaluator::evaluatePieceDevelopment(const Board& board, const AttackInfo& attackInfo) const {
     int score = 0;
     
     // define starting positions for pieces
@@ -255,128 +452,119 @@ int Evaluator::evaluatePieceDevelopment(const Board& board) const {
         Position(6, 5)  // g6
     };
     
-    // track pieces that have moved from starting position
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
-            
-            if (piece.isEmpty()) {
-                continue;
-            }
-            
-            // check if the piece is under attack
-            bool isUnderAttack = false;
+    // track pieces that have moved from starting position (only knights, bishops and rooks are scored)
+    Bitboard developed = board.getPieces(PieceType::KNIGHT) | board.getPieces(PieceType::BISHOP) |
+                         board.getPieces(PieceType::ROOK);
+    while (developed) {
+        Position pos = Position::fromIndex(popLsb(developed));
+        Piece piece = board.getPiece(pos);
+        
+        // check if the piece is under attack
+        bool isUnderAttack = attackInfo.isAttacked(pos, opposite(piece.getColor()));
+        
+        // handle knights
+        if (piece.getType() == PieceType::KNIGHT) {
             if (piece.getColor() == Color::WHITE) {
-                isUnderAttack = board.isUnderAttack(pos, Color::BLACK);
-            } else {
-                isUnderAttack = board.isUnderAttack(pos, Color::WHITE);
-            }
-            
-            // handle knights
-            if (piece.getType() == PieceType::KNIGHT) {
-                if (piece.getColor() == Color::WHITE) {
-                    // check if knight is not on starting square
-                    if (pos != whiteKnightStartPos[0] && pos != whiteKnightStartPos[1]) {
-                        bool onGoodSquare = false;
-                        
-                        // check if knight is on a good development square
-                        for (const auto& goodSquare : goodWhiteKnightSquares) {
-                            if (pos == goodSquare) {
-                                onGoodSquare = true;
-                                break;
-                            }
-                        }
-                        
-                        // If knight is not on a good square and not under attack, apply penalty
-                        if (!onGoodSquare && !isUnderAttack) {
-                            // Penalize knight for being on a suboptimal square
-                            // this indirectly penalizes moving the same piece multiple times
-                            score -= 8;
+                // check if knight is not on starting square
+                if (pos != whiteKnightStartPos[0] && pos != whiteKnightStartPos[1]) {
+                    bool onGoodSquare = false;
+                    
+                    // check if knight is on a good development square
+                    for (const auto& goodSquare : goodWhiteKnightSquares) {
+                        if (pos == goodSquare) {
+                            onGoodSquare = true;
+                            break;
                         }
                     }
-                } else { // BLACK
-                    // check if knight is not on starting square
-                    if (pos != blackKnightStartPos[0] && pos != blackKnightStartPos[1]) {
-                        bool onGoodSquare = false;
-                        
-                        // check if knight is on a good development square
-                        for (const auto& goodSquare : goodBlackKnightSquares) {
-                            if (pos == goodSquare) {
-                                onGoodSquare = true;
-                                break;
-                            }
-                        }
-                        
-                        // if knight is not on a good square and not under attack, apply penalty
-                        if (!onGoodSquare && !isUnderAttack) {
-                            // penalize knight for being on a suboptimal square
-                            score += 8; // positive for white's advantage
+                    
+                    // If knight is not on a good square and not under attack, apply penalty
+                    if (!onGoodSquare && !isUnderAttack) {
+                        // Penalize knight for being on a suboptimal square
+                        // this indirectly penalizes moving the same piece multiple times
+                        score -= 8;
+                    }
+                }
+            } else { // BLACK
+                // check if knight is not on starting square
+                if (pos != blackKnightStartPos[0] && pos != blackKnightStartPos[1]) {
+                    bool onGoodSquare = false;
+                    
+                    // check if knight is on a good development square
+                    for (const auto& goodSquare : goodBlackKnightSquares) {
+                        if (pos == goodSquare) {
+                            onGoodSquare = true;
+                            break;
                         }
                     }
+                    
+                    // if knight is not on a good square and not under attack, apply penalty
+                    if (!onGoodSquare && !isUnderAttack) {
+                        // penalize knight for being on a suboptimal square
+                        score += 8; // positive for white's advantage
+                    }
                 }
             }
-            
-            // handle bishops
-            else if (piece.getType() == PieceType::BISHOP) {
-                if (piece.getColor() == Color::WHITE) {
-                    // check if bishop is not on starting square
-                    if (pos != whiteBishopStartPos[0] && pos != whiteBishopStartPos[1]) {
-                        bool onGoodSquare = false;
-                        
-                        // check if bishop is on a good development square
-                        for (const auto& goodSquare : goodWhiteBishopSquares) {
-                            if (pos == goodSquare) {
-                                onGoodSquare = true;
-                                break;
-                            }
-                        }
-                        
-                        // if bishop is not on a good square and not under attack, apply penalty
-                        if (!onGoodSquare && !isUnderAttack) {
-                            // penalize bishop for being on a suboptimal square
-                            score -= 8;
+        }
+        
+        // handle bishops
+        else if (piece.getType() == PieceType::BISHOP) {
+            if (piece.getColor() == Color::WHITE) {
+                // check if bishop is not on starting square
+                if (pos != whiteBishopStartPos[0] && pos != whiteBishopStartPos[1]) {
+                    bool onGoodSquare = false;
+                    
+                    // check if bishop is on a good development square
+                    for (const auto& goodSquare : goodWhiteBishopSquares) {
+                        if (pos == goodSquare) {
+                            onGoodSquare = true;
+                            break;
                         }
                     }
-                } else { // BLACK
-                    // check if bishop is not on starting square
-                    if (pos != blackBishopStartPos[0] && pos != blackBishopStartPos[1]) {
-                        bool onGoodSquare = false;
-                        
-                        // check if bishop is on a good development square
-                        for (const auto& goodSquare : goodBlackBishopSquares) {
-                            if (pos == goodSquare) {
-                                onGoodSquare = true;
-                                break;
-                            }
-                        }
-                        
-                        // if bishop is not on a good square and not under attack, apply penalty
-                        if (!onGoodSquare && !isUnderAttack) {
-                            // penalize bishop for being on a suboptimal square
-                            score += 8; // positive for white's advantage
+                    
+                    // if bishop is not on a good square and not under attack, apply penalty
+                    if (!onGoodSquare && !isUnderAttack) {
+                        // penalize bishop for being on a suboptimal square
+                        score -= 8;
+                    }
+                }
+            } else { // BLACK
+                // check if bishop is not on starting square
+                if (pos != blackBishopStartPos[0] && pos != blackBishopStartPos[1]) {
+                    bool onGoodSquare = false;
+                    
+                    // check if bishop is on a good development square
+                    for (const auto& goodSquare : goodBlackBishopSquares) {
+                        if (pos == goodSquare) {
+                            onGoodSquare = true;
+                            break;
                         }
                     }
+                    
+                    // if bishop is not on a good square and not under attack, apply penalty
+                    if (!onGoodSquare && !isUnderAttack) {
+                        // penalize bishop for being on a suboptimal square
+                        score += 8; // positive for white's advantage
+                    }
                 }
             }
-            
-            // handle rooks - they generally shouldn't move early unless there's a good reason (rb1 reference those who know)
-            else if (piece.getType() == PieceType::ROOK) {
-                if (piece.getColor() == Color::WHITE) {
-                    // check if rook is not on starting square
-                    if (pos != whiteRookStartPos[0] && pos != whiteRookStartPos[1]) {
-                        // if rook is not under attack, apply penalty for early movement
-                        if (!isUnderAttack) {
-                            score -= 10;
-                        }
+        }
+        
+        // handle rooks - they generally shouldn't move early unless there's a good reason (rb1 reference those who know)
+        else if (piece.getType() == PieceType::ROOK) {
+            if (piece.getColor() == Color::WHITE) {
+                // check if rook is not on starting square
+                if (pos != whiteRookStartPos[0] && pos != whiteRookStartPos[1]) {
+                    // if rook is not under attack, apply penalty for early movement
+                    if (!isUnderAttack) {
+                        score -= 10;
                     }
-                } else { // BLACK
-                    // check if rook is not on starting square
-                    if (pos != blackRookStartPos[0] && pos != blackRookStartPos[1]) {
-                        // if rook is not under attack, apply penalty for early movement
-                        if (!isUnderAttack) {
-                            score += 10; // positive for white's advantage
-                        }
+                }
+            } else { // BLACK
+                // check if rook is not on starting square
+                if (pos != blackRookStartPos[0] && pos != blackRookStartPos[1]) {
+                    // if rook is not under attack, apply penalty for early movement
+                    if (!isUnderAttack) {
+                        score += 10; // positive for white's advantage
                     }
                 }
             }
@@ -398,38 +586,35 @@ int Evaluator::evaluateEarlyKingMovement(const Board& board) const {
     bool blackCanCastle = false;
     
     // Scan the board to find the kings
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
-            
-            if (piece.getType() == PieceType::KING) {
-                if (piece.getColor() == Color::WHITE) {
-                    // If white king is not on its starting square
-                    if (pos != whiteKingStartPos) {
-                        // Check if king moved above first rank (rank > 0) but castling might still be possible
-                        if (pos.rank > 0) {
-                            // Heavy penalty for moving king above first rank before castling
-                            // -50 points is a significant penalty (roughly half a pawn)
-                            score -= 50;
-                            
-                            // Additional penalty based on how far the king moved vertically
-                            score -= pos.rank * 10;
-                        }
-                    }
-                } else { // BLACK
-                    // If black king is not on its starting square
-                    if (pos != blackKingStartPos) {
-                        // Check if king moved below last rank (rank < 7) but castling might still be possible
-                        if (pos.rank < 7) {
-                            // Heavy penalty for moving king below last rank before castling
-                            // +50 points is a significant penalty (positive for white's advantage)
-                            score += 50;
-                            
-                            // Additional penalty based on how far the king moved vertically
-                            score += (7 - pos.rank) * 10;
-                        }
-                    }
+    Bitboard kings = board.getPieces(PieceType::KING);
+    while (kings) {
+        Position pos = Position::fromIndex(popLsb(kings));
+        Piece piece = board.getPiece(pos);
+        
+        if (piece.getColor() == Color::WHITE) {
+            // If white king is not on its starting square
+            if (pos != whiteKingStartPos) {
+                // Check if king moved above first rank (rank > 0) but castling might still be possible
+                if (pos.rank > 0) {
+                    // Heavy penalty for moving king above first rank before castling
+                    // -50 points is a significant penalty (roughly half a pawn)
+                    score -= 50;
+                    
+                    // Additional penalty based on how far the king moved vertically
+                    score -= pos.rank * 10;
+                }
+            }
+        } else { // BLACK
+            // If black king is not on its starting square
+            if (pos != blackKingStartPos) {
+                // Check if king moved below last rank (rank < 7) but castling might still be possible
+                if (pos.rank < 7) {
+                    // Heavy penalty for moving king below last rank before castling
+                    // +50 points is a significant penalty (positive for white's advantage)
+                    score += 50;
+                    
+                    // Additional penalty based on how far the king moved vertically
+                    score += (7 - pos.rank) * 10;
                 }
             }
         }
@@ -454,70 +639,67 @@ int Evaluator::evaluateCastling(const Board& board) const {
     const Position blackQueensideCastlePos(2, 7); // c8
     
     // Scan the board to find the kings
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
-            
-            if (piece.getType() == PieceType::KING) {
-                if (piece.getColor() == Color::WHITE) {
-                    // Check if king has castled kingside
-                    if (pos == whiteKingsideCastlePos) {
-                        // Significant bonus for successful castling
-                        score += 40;
-                    }
-                    // Check if king has castled queenside
-                    else if (pos == whiteQueensideCastlePos) {
-                        // Significant bonus for successful castling
-                        score += 40;
-                    }
-                    // If king is still on starting square, give a small bonus for maintaining castling rights
-                    else if (pos == whiteKingStartPos) {
-                        // Check if rooks are still on their starting squares
-                        Piece kingsideRook = board.getPiece(Position(7, 0)); // h1
-                        Piece queensideRook = board.getPiece(Position(0, 0)); // a1
-                        
-                        // Bonus for maintaining kingside castling option
-                        if (!kingsideRook.isEmpty() && kingsideRook.getType() == PieceType::ROOK && 
-                            kingsideRook.getColor() == Color::WHITE) {
-                            score += 15;
-                        }
-                        
-                        // Bonus for maintaining queenside castling option
-                        if (!queensideRook.isEmpty() && queensideRook.getType() == PieceType::ROOK && 
-                            queensideRook.getColor() == Color::WHITE) {
-                            score += 10; // Slightly less bonus for queenside as it's slightly less common
-                        }
-                    }
-                } else { // BLACK
-                    // Check if king has castled kingside
-                    if (pos == blackKingsideCastlePos) {
-                        // Significant bonus for successful castling (negative for white's advantage)
-                        score -= 40;
-                    }
-                    // Check if king has castled queenside
-                    else if (pos == blackQueensideCastlePos) {
-                        // Significant bonus for successful castling (negative for white's advantage)
-                        score -= 40;
-                    }
-                    // If king is still on starting square, give a small bonus for maintaining castling rights
-                    else if (pos == blackKingStartPos) {
-                        // Check if rooks are still on their starting squares
-                        Piece kingsideRook = board.getPiece(Position(7, 7)); // h8
-                        Piece queensideRook = board.getPiece(Position(0, 7)); // a8
-                        
-                        // Bonus for maintaining kingside castling option
-                        if (!kingsideRook.isEmpty() && kingsideRook.getType() == PieceType::ROOK && 
-                            kingsideRook.getColor() == Color::BLACK) {
-                            score -= 15;
-                        }
-                        
-                        // Bonus for maintaining queenside castling option
-                        if (!queensideRook.isEmpty() && queensideRook.getType() == PieceType::ROOK && 
-                            queensideRook.getColor() == Color::BLACK) {
-                            score -= 10; // Slightly less bonus for queenside as it's slightly less common
-                        }
-                    }
+    Bitboard kings = board.getPieces(PieceType::KING);
+    while (kings) {
+        Position pos = Position::fromIndex(popLsb(kings));
+        Piece piece = board.getPiece(pos);
+        
+        if (piece.getColor() == Color::WHITE) {
+            // Check if king has castled kingside
+            if (pos == whiteKingsideCastlePos) {
+                // Significant bonus for successful castling
+                score += 40;
+            }
+            // Check if king has castled queenside
+            else if (pos == whiteQueensideCastlePos) {
+                // Significant bonus for successful castling
+                score += 40;
+            }
+            // If king is still on starting square, give a small bonus for maintaining castling rights
+            else if (pos == whiteKingStartPos) {
+                // Check if rooks are still on their starting squares
+                Piece kingsideRook = board.getPiece(Position(7, 0)); // h1
+                Piece queensideRook = board.getPiece(Position(0, 0)); // a1
+                
+                // Bonus for maintaining kingside castling option
+                if (!kingsideRook.isEmpty() && kingsideRook.getType() == PieceType::ROOK && 
+                    kingsideRook.getColor() == Color::WHITE) {
+                    score += 15;
+                }
+                
+                // Bonus for maintaining queenside castling option
+                if (!queensideRook.isEmpty() && queensideRook.getType() == PieceType::ROOK && 
+                    queensideRook.getColor() == Color::WHITE) {
+                    score += 10; // Slightly less bonus for queenside as it's slightly less common
+                }
+            }
+        } else { // BLACK
+            // Check if king has castled kingside
+            if (pos == blackKingsideCastlePos) {
+                // Significant bonus for successful castling (negative for white's advantage)
+                score -= 40;
+            }
+            // Check if king has castled queenside
+            else if (pos == blackQueensideCastlePos) {
+                // Significant bonus for successful castling (negative for white's advantage)
+                score -= 40;
+            }
+            // If king is still on starting square, give a small bonus for maintaining castling rights
+            else if (pos == blackKingStartPos) {
+                // Check if rooks are still on their starting squares
+                Piece kingsideRook = board.getPiece(Position(7, 7)); // h8
+                Piece queensideRook = board.getPiece(Position(0, 7)); // a8
+                
+                // Bonus for maintaining kingside castling option
+                if (!kingsideRook.isEmpty() && kingsideRook.getType() == PieceType::ROOK && 
+                    kingsideRook.getColor() == Color::BLACK) {
+                    score -= 15;
+                }
+                
+                // Bonus for maintaining queenside castling option
+                if (!queensideRook.isEmpty() && queensideRook.getType() == PieceType::ROOK && 
+                    queensideRook.getColor() == Color::BLACK) {
+                    score -= 10; // Slightly less bonus for queenside as it's slightly less common
                 }
             }
         }
@@ -526,20 +708,12 @@ int Evaluator::evaluateCastling(const Board& board) const {
     return score;
 }
 
-int Evaluator::evaluatePawnDoubleMoves(const Board& board) const {
+int Evaluator::evaluatePawnDoubleMoves(const Board& board, const AttackInfo& attackInfo) const {
     int score = 0;
     
     // Only apply this evaluation in the opening phase (first 10 moves)
     // We can estimate this by counting the total pieces on the board
-    int pieceCount = 0;
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            Piece piece = board.getPiece(Position(file, rank));
-            if (!piece.isEmpty()) {
-                pieceCount++;
-            }
-        }
-    }
+    int pieceCount = popCount(board.getOccupied());
     
     // If we're not in the opening phase (too many pieces missing), return early
     if (pieceCount < 28) { // 32 pieces at start, allow for a few captures
@@ -560,104 +734,98 @@ int Evaluator::evaluatePawnDoubleMoves(const Board& board) const {
         // Check white pawns
         bool whitePawnFound = false;
         
-        // Check each rank to see if this file's pawn has moved
-        for (int rank = 0; rank < 8; rank++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
+        // Find the lowest pawn on this file to see if it has moved
+        Bitboard whitePawns = board.getPieces(PieceType::PAWN, Color::WHITE) & fileBB(file);
+        if (whitePawns) {
+            Position pos = Position::fromIndex(lsb(whitePawns));
+            int rank = pos.rank;
             
-            if (!piece.isEmpty() && piece.getType() == PieceType::PAWN && piece.getColor() == Color::WHITE) {
-                whitePawnFound = true;
-                
-                // Check if the pawn has moved from its starting position
-                if (rank > whitePawnRank) {
-                    // Check if the pawn has moved more than once
-                    // A pawn on rank 3 (index 2) could have moved there in one move (e2-e4)
-                    // But a pawn on rank 4 (index 3) or higher must have moved multiple times
-                    if (rank > whitePawnRank + 2) {
-                        // Check if the pawn is under attack - if so, we don't penalize movement
-                        bool isUnderAttack = board.isUnderAttack(pos, Color::BLACK);
+            whitePawnFound = true;
+            
+            // Check if the pawn has moved from its starting position
+            if (rank > whitePawnRank) {
+                // Check if the pawn has moved more than once
+                // A pawn on rank 3 (index 2) could have moved there in one move (e2-e4)
+                // But a pawn on rank 4 (index 3) or higher must have moved multiple times
+                if (rank > whitePawnRank + 2) {
+                    // Check if the pawn is under attack - if so, we don't penalize movement
+                    bool isUnderAttack = attackInfo.isAttacked(pos, Color::BLACK);
+                    
+                    if (!isUnderAttack) {
+                        // Base penalty for moving a pawn twice
+                        score -= 20;
                         
-                        if (!isUnderAttack) {
-                            // Base penalty for moving a pawn twice
-                            score -= 20;
-                            
-                            // Extra penalty for center pawns (d and e files)
-                            if (file == 3 || file == 4) {
-                                score -= 10;
-                            }
-                            
-                            // Check if this pawn controls any center squares
-                            bool controlsCenter = false;
-                            for (const auto& centerPos : centerSquares) {
-                                // Pawns control squares diagonally in front of them
-                                if (abs(pos.file - centerPos.file) == 1 && 
-                                    centerPos.rank == pos.rank + 1) {
-                                    controlsCenter = true;
-                                    break;
-                                }
-                            }
-                            
-                            // Extra penalty if it lost center control
-                            if (!controlsCenter && (file == 2 || file == 3 || file == 4 || file == 5)) {
-                                score -= 10;
+                        // Extra penalty for center pawns (d and e files)
+                        if (file == 3 || file == 4) {
+                            score -= 10;
+                        }
+                        
+                        // Check if this pawn controls any center squares
+                        bool controlsCenter = false;
+                        for (const auto& centerPos : centerSquares) {
+                            // Pawns control squares diagonally in front of them
+                            if (abs(pos.file - centerPos.file) == 1 && 
+                                centerPos.rank == pos.rank + 1) {
+                                controlsCenter = true;
+                                break;
                             }
                         }
+                        
+                        // Extra penalty if it lost center control
+                        if (!controlsCenter && (file == 2 || file == 3 || file == 4 || file == 5)) {
+                            score -= 10;
+                        }
                     }
                 }
-                
-                break; // Found the pawn for this file, no need to check further ranks
             }
         }
         
         // Check black pawns
         bool blackPawnFound = false;
         
-        // Check each rank to see if this file's pawn has moved
-        for (int rank = 0; rank < 8; rank++) {
-            Position pos(file, rank);
-            Piece piece = board.getPiece(pos);
+        // Find the lowest pawn on this file to see if it has moved
+        Bitboard blackPawns = board.getPieces(PieceType::PAWN, Color::BLACK) & fileBB(file);
+        if (blackPawns) {
+            Position pos = Position::fromIndex(lsb(blackPawns));
+            int rank = pos.rank;
             
-            if (!piece.isEmpty() && piece.getType() == PieceType::PAWN && piece.getColor() == Color::BLACK) {
-                blackPawnFound = true;
-                
-                // Check if the pawn has moved from its starting position
-                if (rank < blackPawnRank) {
-                    // Check if the pawn has moved more than once
-                    // A pawn on rank 4 (index 4) could have moved there in one move (e7-e5)
-                    // But a pawn on rank 3 (index 3) or lower must have moved multiple times
-                    if (rank < blackPawnRank - 2) {
-                        // Check if the pawn is under attack - if so, we don't penalize movement
-                        bool isUnderAttack = board.isUnderAttack(pos, Color::WHITE);
+            blackPawnFound = true;
+            
+            // Check if the pawn has moved from its starting position
+            if (rank < blackPawnRank) {
+                // Check if the pawn has moved more than once
+                // A pawn on rank 4 (index 4) could have moved there in one move (e7-e5)
+                // But a pawn on rank 3 (index 3) or lower must have moved multiple times
+                if (rank < blackPawnRank - 2) {
+                    // Check if the pawn is under attack - if so, we don't penalize movement
+                    bool isUnderAttack = attackInfo.isAttacked(pos, Color::WHITE);
+                    
+                    if (!isUnderAttack) {
+                        // Base penalty for moving a pawn twice
+                        score += 20; // positive for white's advantage
                         
-                        if (!isUnderAttack) {
-                            // Base penalty for moving a pawn twice
-                            score += 20; // positive for white's advantage
-                            
-                            // Extra penalty for center pawns (d and e files)
-                            if (file == 3 || file == 4) {
-                                score += 10;
-                            }
-                            
-                            // Check if this pawn controls any center squares
-                            bool controlsCenter = false;
-                            for (const auto& centerPos : centerSquares) {
-                                // Pawns control squares diagonally in front of them
-                                if (abs(pos.file - centerPos.file) == 1 && 
-                                    centerPos.rank == pos.rank - 1) {
-                                    controlsCenter = true;
-                                    break;
-                                }
-                            }
-                            
-                            // Extra penalty if it lost center control
-                            if (!controlsCenter && (file == 2 || file == 3 || file == 4 || file == 5)) {
-                                score += 10;
+                        // Extra penalty for center pawns (d and e files)
+                        if (file == 3 || file == 4) {
+                            score += 10;
+                        }
+                        
+                        // Check if this pawn controls any center squares
+                        bool controlsCenter = false;
+                        for (const auto& centerPos : centerSquares) {
+                            // Pawns control squares diagonally in front of them
+                            if (abs(pos.file - centerPos.file) == 1 && 
+                                centerPos.rank == pos.rank - 1) {
+                                controlsCenter = true;
+                                break;
                             }
                         }
+                        
+                        // Extra penalty if it lost center control
+                        if (!controlsCenter && (file == 2 || file == 3 || file == 4 || file == 5)) {
+                            score += 10;
+                        }
                     }
                 }
-                
-                break; // Found the pawn for this file, no need to check further ranks
             }
         }
     }
@@ -0,0 +1,170 @@
+#include "chess/movepick.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace chess {
+
+namespace {
+
+// rough piece values for ordering, indexed by PieceType (a king capturing is always safe)
+constexpr int orderValues[7] = {0, 100, 320, 330, 500, 900, 0};
+
+int value(PieceType type) {
+    return orderValues[static_cast<int>(type)];
+}
+
+} // anonymous namespace
+
+void HistoryTable::clear() {
+    std::fill(&table[0][0][0], &table[0][0][0] + 2 * 64 * 64, 0);
+}
+
+void HistoryTable::update(Color side, Move move, int bonus) {
+    int& entry = table[side == Color::BLACK][move.fromSquare()][move.toSquare()];
+    bonus = std::max(-MAX, std::min(bonus, MAX));
+    entry += bonus - entry * std::abs(bonus) / MAX;
+}
+
+MovePicker::MovePicker(const Board& board, Move ttMove, const Move killers[2], const HistoryTable& history)
+    : board(board), history(history), ttMove(ttMove), stage(TT_MOVE), killerIndex(0), capturesOnly(false),
+      captureIndex(0), quietIndex(0), badCaptureIndex(0), capturesGenerated(false), quietsGenerated(false) {
+    this->killers[0] = killers ? killers[0] : Move();
+    this->killers[1] = killers ? killers[1] : Move();
+}
+
+MovePicker::MovePicker(const Board& board, Move ttMove, const HistoryTable& history)
+    : MovePicker(board, ttMove, nullptr, history) {
+    capturesOnly = true;
+    
+    // a quiet hash move doesn't belong in a captures-only search
+    if (!ttMove.isNull() && !board.isCapture(ttMove) && ttMove.flag() != Move::PROMOTION) {
+        this->ttMove = Move();
+    }
+}
+
+void MovePicker::generateCaptures() {
+    if (capturesGenerated) {
+        return;
+    }
+    capturesGenerated = true;
+    captures = board.generateLegalMoves(MoveGenType::CAPTURES);
+    
+    // MVV-LVA: the most valuable victim first, and the cheapest attacker among equal victims
+    for (int i = 0; i < captures.size(); i++) {
+        Move move = captures[i];
+        PieceType victim = move.flag() == Move::EN_PASSANT ? PieceType::PAWN
+                                                           : board.getPiece(move.to()).getType();
+        PieceType attacker = board.getPiece(move.from()).getType();
+        captureScores[i] = value(victim) * 16 + value(move.promotion()) * 16 - value(attacker) / 10;
+    }
+}
+
+void MovePicker::generateQuiets() {
+    if (quietsGenerated) {
+        return;
+    }
+    quietsGenerated = true;
+    quiets = board.generateLegalMoves(MoveGenType::QUIETS);
+    
+    Color side = board.getSideToMove();
+    for (int i = 0; i < quiets.size(); i++) {
+        quietScores[i] = history.get(side, quiets[i]);
+    }
+}
+
+Move MovePicker::pickBest(MoveList& moves, int* scores, int& index) {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+    return moves[index++];
+}
+
+Move MovePicker::next() {
+    switch (stage) {
+        case TT_MOVE: {
+            stage = INIT_CAPTURES;
+            if (ttMove.isNull()) {
+                return next();
+            }
+            
+            // the hash move may come from a different position with the same key, so it
+            // only gets played if it shows up in the half of the moves it belongs to
+            bool noisy = board.isCapture(ttMove) || ttMove.flag() == Move::PROMOTION;
+            if (noisy) {
+                generateCaptures();
+            } else {
+                generateQuiets();
+            }
+            
+            const MoveList& list = noisy ? captures : quiets;
+            if (std::find(list.begin(), list.end(), ttMove) != list.end()) {
+                return ttMove;
+            }
+            
+            ttMove = Move();
+            return next();
+        }
+        
+        case INIT_CAPTURES:
+            generateCaptures();
+            stage = CAPTURES;
+            return next();
+        
+        case CAPTURES:
+            while (captureIndex < captures.size()) {
+                Move move = pickBest(captures, captureScores, captureIndex);
+                if (move == ttMove) {
+                    continue;
+                }
+                
+                // captures that lose material wait until after the quiets
+                if (!capturesOnly && board.see(move) < 0) {
+                    badCaptures.push_back(move);
+                    continue;
+                }
+                return move;
+            }
+            stage = capturesOnly ? DONE : KILLERS;
+            return next();
+        
+        case KILLERS:
+            generateQuiets();
+            while (killerIndex < 2) {
+                Move killer = killers[killerIndex++];
+                if (!killer.isNull() && killer != ttMove && (killerIndex == 1 || killer != killers[0]) &&
+                    std::find(quiets.begin(), quiets.end(), killer) != quiets.end()) {
+                    return killer;
+                }
+            }
+            stage = QUIETS;
+            return next();
+        
+        case QUIETS:
+            while (quietIndex < quiets.size()) {
+                Move move = pickBest(quiets, quietScores, quietIndex);
+                if (move != ttMove && move != killers[0] && move != killers[1]) {
+                    return move;
+                }
+            }
+            stage = BAD_CAPTURES;
+            return next();
+        
+        case BAD_CAPTURES:
+            if (badCaptureIndex < badCaptures.size()) {
+                return badCaptures[badCaptureIndex++];
+            }
+            stage = DONE;
+            return Move();
+        
+        default:
+            return Move();
+    }
+}
+
+} // namespace chess
@@ -0,0 +1,184 @@
+#include "chess/packed.h"
+#include <algorithm>
+
+namespace chess {
+
+namespace {
+
+// positions per block read or written at once (128 KB)
+const size_t BLOCK_POSITIONS = 4096;
+
+const int MAX_PIECES = 32;
+const int NO_EN_PASSANT = 64;
+const uint8_t BLACK_NIBBLE = 8;
+const Bitboard BACK_RANKS = RANK_1_BB | (RANK_1_BB << 56);
+
+} // anonymous namespace
+
+bool Board::writePacked(PackedPosition& packed) const {
+    Bitboard occupied = getOccupied();
+    if (popCount(occupied) > MAX_PIECES) {
+        return false;
+    }
+    
+    std::fill(std::begin(packed.bytes), std::end(packed.bytes), 0);
+    for (int i = 0; i < 8; i++) {
+        packed.bytes[i] = static_cast<uint8_t>(occupied >> (8 * i));
+    }
+    
+    for (int index = 0; occupied; index++) {
+        Piece piece = mailbox[popLsb(occupied)];
+        uint8_t nibble = static_cast<uint8_t>(static_cast<int>(piece.getType()) |
+                                              (piece.getColor() == Color::BLACK ? BLACK_NIBBLE : 0));
+        packed.bytes[8 + index / 2] |= static_cast<uint8_t>(nibble << (4 * (index & 1)));
+    }
+    
+    packed.bytes[24] = sideToMove == Color::BLACK ? 1 : 0;
+    packed.bytes[25] = castlingRights;
+    packed.bytes[26] = static_cast<uint8_t>(enPassantTarget.isValid() ? enPassantTarget.toIndex() : NO_EN_PASSANT);
+    packed.bytes[27] = static_cast<uint8_t>(std::min(std::max(halfMoveClock, 0), 255));
+    
+    int fullMove = std::min(std::max(fullMoveNumber, 0), 65535);
+    packed.bytes[28] = static_cast<uint8_t>(fullMove);
+    packed.bytes[29] = static_cast<uint8_t>(fullMove >> 8);
+    return true;
+}
+
+bool Board::loadPacked(const PackedPosition& packed) {
+    reset();
+    
+    Bitboard occupied = 0;
+    for (int i = 0; i < 8; i++) {
+        occupied |= static_cast<Bitboard>(packed.bytes[i]) << (8 * i);
+    }
+    
+    bool valid = popCount(occupied) <= MAX_PIECES;
+    for (int index = 0; valid && occupied; index++) {
+        uint8_t nibble = (packed.bytes[8 + index / 2] >> (4 * (index & 1))) & 0xF;
+        int type = nibble & 7;
+        int square = popLsb(occupied);
+        
+        // check before placing it, setPiece indexes its tables by type. Pawns can't be on the
+        // first or last rank, like in a FEN
+        valid = type >= static_cast<int>(PieceType::PAWN) && type <= static_cast<int>(PieceType::KING) &&
+                !(type == static_cast<int>(PieceType::PAWN) && (squareBB(square) & BACK_RANKS));
+        if (!valid) {
+            break;
+        }
+        
+        Color color = (nibble & BLACK_NIBBLE) ? Color::BLACK : Color::WHITE;
+        setPiece(Position::fromIndex(square), Piece(static_cast<PieceType>(type), color));
+    }
+    
+    // the en passant square is on the third or sixth rank like in a FEN
+    int enPassant = packed.bytes[26];
+    int enPassantRank = enPassant >> 3;
+    valid = valid && packed.bytes[24] <= 1 && packed.bytes[25] <= 15 &&
+            (enPassant == NO_EN_PASSANT || (enPassant < 64 && (enPassantRank == 2 || enPassantRank == 5)));
+    
+    if (!valid) {
+        reset();
+        return false;
+    }
+    
+    sideToMove = packed.bytes[24] ? Color::BLACK : Color::WHITE;
+    castlingRights = packed.bytes[25];
+    if (enPassant != NO_EN_PASSANT) {
+        enPassantTarget = Position::fromIndex(enPassant);
+    }
+    halfMoveClock = packed.bytes[27];
+    fullMoveNumber = packed.bytes[28] | (packed.bytes[29] << 8);
+    
+    key ^= stateKey();
+    return true;
+}
+
+// packed writer
+PackedWriter::PackedWriter(const std::string& path)
+    : file(std::fopen(path.c_str(), "wb")), buffer(BLOCK_POSITIONS), buffered(0), written(0), failed(false) {}
+
+PackedWriter::~PackedWriter() {
+    if (file) {
+        flush();
+        std::fclose(file);
+    }
+}
+
+bool PackedWriter::write(const Board& board) {
+    PackedPosition packed;
+    return board.writePacked(packed) && write(packed);
+}
+
+bool PackedWriter::write(const PackedPosition& packed) {
+    if (!file || failed) {
+        return false;
+    }
+    
+    buffer[buffered++] = packed;
+    written++;
+    return buffered < buffer.size() || flush();
+}
+
+bool PackedWriter::flush() {
+    if (!file) {
+        return false;
+    }
+    
+    if (buffered > 0 && !failed) {
+        failed = std::fwrite(buffer.data(), sizeof(PackedPosition), buffered, file) != buffered;
+        buffered = 0;
+    }
+    return !failed && std::fflush(file) == 0;
+}
+
+// packed reader
+PackedReader::PackedReader(const std::string& path)
+    : file(std::fopen(path.c_str(), "rb")), buffer(BLOCK_POSITIONS), filled(0), next(0), readCount(0), failed(false) {}
+
+PackedReader::~PackedReader() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool PackedReader::refill() {
+    if (!file || failed) {
+        return false;
+    }
+    
+    filled = std::fread(buffer.data(), sizeof(PackedPosition), buffer.size(), file);
+    next = 0;
+    
+    if (filled < buffer.size()) {
+        // a short block is the end of the file, unless it was an error or the file ends
+        // halfway through a record
+        long position = std::ftell(file);
+        failed = std::ferror(file) || (position >= 0 && position % static_cast<long>(sizeof(PackedPosition)) != 0);
+    }
+    return filled > 0;
+}
+
+bool PackedReader::read(PackedPosition& packed) {
+    if (next == filled && !refill()) {
+        return false;
+    }
+    
+    packed = buffer[next++];
+    readCount++;
+    return true;
+}
+
+bool PackedReader::read(Board& board) {
+    PackedPosition packed;
+    if (!read(packed)) {
+        return false;
+    }
+    
+    if (!board.loadPacked(packed)) {
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+} // namespace chess
@@ -4,12 +4,12 @@
 namespace chess {
 
 char Piece::toChar() const {
-    if (type == PieceType::EMPTY) {
+    if (getType() == PieceType::EMPTY) {
         return ' ';
     }
     
     char c;
-    switch (type) {
+    switch (getType()) {
         case PieceType::PAWN:   c = 'P'; break;
         case PieceType::KNIGHT: c = 'N'; break;
         case PieceType::BISHOP: c = 'B'; break;
@@ -19,11 +19,11 @@ char Piece::toChar() const {
         default:                c = '?'; break;
     }
     
-    return (color == Color::WHITE) ? c : std::tolower(c);
+    return (getColor() == Color::WHITE) ? c : std::tolower(c);
 }
 
 int Piece::getValue() const {
-    switch (type) {
+    switch (getType()) {
         case PieceType::PAWN:   return 100;
         case PieceType::KNIGHT: return 320;
         case PieceType::BISHOP: return 330;
@@ -35,12 +35,12 @@ int Piece::getValue() const {
 }
 
 char Piece::toFEN() const {
-    if (type == PieceType::EMPTY) {
+    if (getType() == PieceType::EMPTY) {
         return ' ';
     }
     
     char c;
-    switch (type) {
+    switch (getType()) {
         case PieceType::PAWN:   c = 'p'; break;
         case PieceType::KNIGHT: c = 'n'; break;
         case PieceType::BISHOP: c = 'b'; break;
@@ -50,7 +50,7 @@ char Piece::toFEN() const {
         default:                c = '?'; break;
     }
     
-    return (color == Color::WHITE) ? std::toupper(c) : c;
+    return (getColor() == Color::WHITE) ? std::toupper(c) : c;
 }
 
 Piece Piece::fromFEN(char fen) {
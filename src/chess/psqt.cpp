@@ -0,0 +1,156 @@
+#include "chess/psqt.h"
+
+namespace chess {
+namespace psqt {
+
+Score table[3][7][64];
+int phaseWeight[7];
+
+namespace {
+
+// tables are written the way the board looks from white's side: a8 top left, h1 bottom right
+using Table = int[64];
+
+const Table pawnMg = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+// in the endgame what counts for a pawn is how close it is to queening
+const Table pawnEg = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+    100, 100, 100, 100, 100, 100, 100, 100,
+     60,  60,  60,  60,  60,  60,  60,  60,
+     35,  35,  35,  35,  35,  35,  35,  35,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const Table knight = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const Table bishop = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const Table rook = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+const Table queen = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+// the king hides behind its pawns while there is material to attack it...
+const Table kingMg = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+// ...and comes out to the center once it's gone
+const Table kingEg = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+struct PieceTables {
+    PieceType type;
+    int valueMg;
+    int valueEg;
+    const int* mg;
+    const int* eg;
+    int phase;
+};
+
+const PieceTables pieceTables[] = {
+    {PieceType::PAWN,   100, 110, pawnMg, pawnEg, 0},
+    {PieceType::KNIGHT, 320, 300, knight, knight, 1},
+    {PieceType::BISHOP, 330, 320, bishop, bishop, 1},
+    {PieceType::ROOK,   500, 520, rook,   rook,   2},
+    {PieceType::QUEEN,  900, 920, queen,  queen,  4},
+    {PieceType::KING,   0,   0,   kingMg, kingEg, 0}
+};
+
+// build the tables before main runs
+struct Initializer {
+    Initializer() { init(); }
+} initializer;
+
+} // namespace
+
+void init() {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+    
+    for (const PieceTables& piece : pieceTables) {
+        int type = static_cast<int>(piece.type);
+        phaseWeight[type] = piece.phase;
+        
+        for (int square = 0; square < 64; square++) {
+            // white reads the table upside down (a1 is the bottom left), black mirrored
+            int whiteIndex = square ^ 56;
+            int blackIndex = square;
+            
+            Score& white = table[static_cast<int>(Color::WHITE)][type][square];
+            white.mg = piece.valueMg + piece.mg[whiteIndex];
+            white.eg = piece.valueEg + piece.eg[whiteIndex];
+            
+            Score& black = table[static_cast<int>(Color::BLACK)][type][square];
+            black.mg = -(piece.valueMg + piece.mg[blackIndex]);
+            black.eg = -(piece.valueEg + piece.eg[blackIndex]);
+        }
+    }
+}
+
+} // namespace psqt
+} // namespace chess
@@ -0,0 +1,124 @@
+#include "chess/transposition.h"
+
+namespace chess {
+
+namespace {
+
+// data layout: move 0-15, score 16-31, depth 32-39, bound 40-41, age 42-47
+uint64_t pack(Move move, int score, int depth, Bound bound, unsigned age) {
+    return static_cast<uint64_t>(move.raw()) |
+           static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16 |
+           static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32 |
+           static_cast<uint64_t>(bound) << 40 |
+           static_cast<uint64_t>(age) << 42;
+}
+
+Move dataMove(uint64_t data) { return Move::fromRaw(static_cast<uint16_t>(data)); }
+int dataScore(uint64_t data) { return static_cast<int16_t>(data >> 16); }
+int dataDepth(uint64_t data) { return static_cast<int8_t>(data >> 32); }
+Bound dataBound(uint64_t data) { return static_cast<Bound>((data >> 40) & 3); }
+unsigned dataAge(uint64_t data) { return (data >> 42) & 0x3F; }
+
+} // anonymous namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) : bucketCount(0), age(0) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t count = megabytes * 1024 * 1024 / sizeof(Bucket);
+    if (count == 0) {
+        count = 1;
+    }
+    
+    if (count != bucketCount) {
+        buckets.reset(new Bucket[count]);
+        bucketCount = count;
+    }
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; i++) {
+        for (Slot& slot : buckets[i].slots) {
+            slot.key.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    age = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    for (const Slot& slot : bucketFor(key).slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if ((slot.key.load(std::memory_order_relaxed) ^ data) != key || dataBound(data) == Bound::NONE) {
+            continue;
+        }
+        
+        entry.move = dataMove(data);
+        entry.score = dataScore(data);
+        entry.depth = dataDepth(data);
+        entry.bound = dataBound(data);
+        return true;
+    }
+    
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+    Slot* replace = &bucket.slots[0];
+    int worst = 1 << 30;
+    
+    for (Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        
+        // same position: overwrite unless that throws away a clearly deeper result of this
+        // search (a quiescence entry landing on a negamax one), and don't lose a best move we
+        // already know
+        if ((slot.key.load(std::memory_order_relaxed) ^ data) == key) {
+            if (bound != Bound::EXACT && depth < dataDepth(data) - 2 && dataAge(data) == age &&
+                dataBound(data) != Bound::NONE) {
+                return;
+            }
+            if (move.isNull()) {
+                move = dataMove(data);
+            }
+            replace = &slot;
+            break;
+        }
+        
+        // otherwise evict the shallowest entry, counting entries from old searches as shallower
+        int ageDistance = static_cast<int>((age - dataAge(data)) & AGE_MASK);
+        int value = dataDepth(data) - 8 * ageDistance;
+        if (dataBound(data) == Bound::NONE) {
+            value = -(1 << 20);
+        }
+        if (value < worst) {
+            worst = value;
+            replace = &slot;
+        }
+    }
+    
+    uint64_t data = pack(move, score, depth, bound, age);
+    replace->key.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t samples = bucketCount < 250 ? bucketCount : 250;
+    int used = 0;
+    
+    for (size_t i = 0; i < samples; i++) {
+        for (const Slot& slot : buckets[i].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (dataBound(data) != Bound::NONE && dataAge(data) == age) {
+                used++;
+            }
+        }
+    }
+    
+    return samples ? static_cast<int>(used * 1000 / (samples * 4)) : 0;
+}
+
+} // namespace chess
@@ -0,0 +1,67 @@
+#include "chess/zobrist.h"
+
+namespace chess {
+namespace zobrist {
+
+uint64_t pieceKeys[3][7][64];
+uint64_t sideKey;
+uint64_t castlingKeys[16];
+uint64_t enPassantKeys[8];
+
+namespace {
+
+// splitmix64, fixed seed so the keys are the same every run
+uint64_t seed = 0x2545F4914F6CDD1DULL;
+
+uint64_t nextKey() {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// build the keys before main runs
+struct Initializer {
+    Initializer() { init(); }
+} initializer;
+
+} // namespace
+
+void init() {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+    
+    // empty squares (and the NONE color) hash to nothing
+    for (int color = 0; color < 3; color++) {
+        for (int type = 0; type < 7; type++) {
+            for (int square = 0; square < 64; square++) {
+                bool real = color != static_cast<int>(Color::NONE) && type != static_cast<int>(PieceType::EMPTY);
+                pieceKeys[color][type][square] = real ? nextKey() : 0;
+            }
+        }
+    }
+    
+    sideKey = nextKey();
+    
+    // each castling right gets a key, combinations are the XOR of their rights
+    uint64_t rightKeys[4];
+    for (uint64_t& key : rightKeys) {
+        key = nextKey();
+    }
+    for (int rights = 0; rights < 16; rights++) {
+        castlingKeys[rights] = 0;
+        for (int bit = 0; bit < 4; bit++) {
+            if (rights & (1 << bit)) {
+                castlingKeys[rights] ^= rightKeys[bit];
+            }
+        }
+    }
+    
+    for (uint64_t& key : enPassantKeys) {
+        key = nextKey();
+    }
+}
+
+} // namespace zobrist
+} // namespace chess
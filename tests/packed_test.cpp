@@ -0,0 +1,169 @@
+// checks for FEN parsing and the packed position format: positions survive the round trip
+// FEN -> packed -> FEN, and malformed input is rejected without touching anything out of range
+//
+// usage:
+//   brothfish-packed-test                        exits non-zero if a check fails
+
+#include "chess/board.h"
+#include "chess/packed.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// positions with every field in use: castling, en passant, promotions coming up, move counters
+const char* roundTripFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "rnbqkbnr/pp1ppppp/8/2pP4/8/8/PPP1PPPP/RNBQKBNR w KQkq c6 0 3",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "8/8/8/8/8/8/8/K6k b - - 99 312",
+};
+
+void testRoundTrip() {
+    chess::Board board;
+    chess::Board unpacked;
+    chess::PackedPosition packed;
+    
+    for (const char* fen : roundTripFens) {
+        check(board.loadFEN(fen), std::string("loadFEN ") + fen);
+        check(board.toFEN() == fen, std::string("FEN round trip ") + fen + " -> " + board.toFEN());
+        
+        check(board.writePacked(packed), std::string("writePacked ") + fen);
+        check(unpacked.loadPacked(packed), std::string("loadPacked ") + fen);
+        check(unpacked.toFEN() == fen, std::string("packed round trip ") + fen + " -> " + unpacked.toFEN());
+        check(unpacked.hash() == chess::Board(fen).hash(), std::string("packed hash ") + fen);
+    }
+}
+
+void testMalformedPacked() {
+    chess::Board source("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    chess::PackedPosition valid;
+    source.writePacked(valid);
+    chess::Board board;
+    
+    // every nibble that isn't a piece (0, 7, 8 and 15) in every piece slot
+    for (int index = 0; index < 32; index++) {
+        for (uint8_t nibble : {0, 7, 8, 15}) {
+            chess::PackedPosition packed = valid;
+            uint8_t& byte = packed.bytes[8 + index / 2];
+            int shift = 4 * (index & 1);
+            byte = static_cast<uint8_t>((byte & ~(0xF << shift)) | (nibble << shift));
+            check(!board.loadPacked(packed) && board.getOccupied() == 0,
+                  "bad nibble " + std::to_string(nibble) + " at piece " + std::to_string(index));
+        }
+    }
+    
+    // more than 32 pieces
+    chess::PackedPosition crowded = valid;
+    for (int i = 0; i < 8; i++) {
+        crowded.bytes[i] = 0xFF;
+    }
+    check(!board.loadPacked(crowded), "more than 32 pieces");
+    
+    // side to move, castling rights and en passant square out of range
+    chess::PackedPosition side = valid;
+    side.bytes[24] = 2;
+    check(!board.loadPacked(side), "side to move 2");
+    
+    chess::PackedPosition castling = valid;
+    castling.bytes[25] = 16;
+    check(!board.loadPacked(castling), "castling rights 16");
+    
+    for (uint8_t square : {0, 27, 63, 65, 255}) {
+        chess::PackedPosition enPassant = valid;
+        enPassant.bytes[26] = square;
+        check(!board.loadPacked(enPassant), "en passant square " + std::to_string(square));
+    }
+    
+    // every byte value in every position of the record never reads out of range (run under a
+    // sanitizer to catch that), and whatever loads writes the same FEN back
+    for (int i = 0; i < 32; i++) {
+        for (int value = 0; value < 256; value++) {
+            chess::PackedPosition packed = valid;
+            packed.bytes[i] = static_cast<uint8_t>(value);
+            if (board.loadPacked(packed)) {
+                chess::Board again(board.toFEN());
+                check(again.hash() == board.hash(), "reloaded hash for byte " + std::to_string(i));
+            }
+        }
+    }
+}
+
+// FENs the parser has to turn down, the board stays empty
+const char* malformedFens[] = {
+    "",
+    "8/8/8/8/8/8/8/8",
+    "8/8/8/8/8/8/8/9 w - - 0 1",
+    "8/8/8/8/8/8/8/8/ w - - 0 1",
+    "8/8/8/8/8/8/8/8K w - - 0 1",
+    "8/8/8/8/8/8/8/7 w - - 0 1",
+    "8/8/8/8/8/8/8 w - - 0 1",
+    "8/8/8/8/8/8/8/8 x - - 0 1",
+    "8/8/8/8/8/8/8/8 w KX - 0 1",
+    "8/8/8/8/8/8/8/8 w - e4 0 1",
+    "8/8/8/8/8/8/8/8 w - - a 1",
+    "8/8/8/8/8/8/8/8 w - - 0 1x",
+    "P3k3/8/8/8/8/8/8/4K3 w - - 0 1",
+    "4k3/8/8/8/8/8/8/4K2p b - - 0 1",
+};
+
+void testMalformedFen() {
+    chess::Board board;
+    for (const char* fen : malformedFens) {
+        check(!board.loadFEN(fen) && board.getOccupied() == 0, std::string("accepted malformed FEN '") + fen + "'");
+    }
+}
+
+void testBackRankPawnsPacked() {
+    // pawns moved onto a back rank by rewriting the occupancy of a lone white and black pawn
+    chess::Board source("4k3/p7/8/8/8/8/7P/4K3 w - - 0 1");
+    chess::PackedPosition valid;
+    source.writePacked(valid);
+    chess::Board board;
+    check(board.loadPacked(valid), "pawns on the second and seventh rank");
+    
+    for (int rankShift : {-8, 8}) {
+        chess::PackedPosition packed = valid;
+        uint64_t occupied = 0;
+        for (int i = 0; i < 8; i++) {
+            occupied |= static_cast<uint64_t>(packed.bytes[i]) << (8 * i);
+        }
+        // h2 -> h1 or a7 -> a8, the order of the pieces by square stays the same
+        uint64_t pawn = rankShift < 0 ? chess::squareBB(15) : chess::squareBB(48);
+        occupied = (occupied & ~pawn) | (rankShift < 0 ? pawn >> 8 : pawn << 8);
+        for (int i = 0; i < 8; i++) {
+            packed.bytes[i] = static_cast<uint8_t>(occupied >> (8 * i));
+        }
+        check(!board.loadPacked(packed) && board.getOccupied() == 0,
+              rankShift < 0 ? "packed pawn on the first rank" : "packed pawn on the last rank");
+    }
+}
+
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testMalformedPacked();
+    testMalformedFen();
+    testBackRankPawnsPacked();
+    
+    if (failures) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+// perft runner: checks move generation against the standard reference positions
+// and reports nodes per second
+//
+// usage:
+//   brothfish-perft [--depth N]                  run the reference suite up to depth N (default 5)
+//   brothfish-perft --fen "<fen>" --depth N      count a single position
+//   brothfish-perft --fen "<fen>" --depth N --divide
+
+#include "chess/board.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    uint64_t expected[6]; // node counts for depth 1..6 (0 = too slow to be worth listing)
+};
+
+// the usual positions from the chess programming wiki
+const PerftPosition referencePositions[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551, 0}},
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printResult(const std::string& name, int depth, uint64_t nodes, double seconds) {
+    std::cout << std::left << std::setw(10) << name << " depth " << depth
+              << "  nodes " << std::setw(12) << nodes
+              << "  time " << std::fixed << std::setprecision(3) << seconds << "s"
+              << "  nps " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int depth = 5;
+    std::string fen;
+    bool divide = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--depth" || arg == "-d") && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (arg == "--fen" && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (arg == "--divide") {
+            divide = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--depth N] [--fen \"<fen>\" [--divide]]" << std::endl;
+            return 2;
+        }
+    }
+    
+    // single position
+    if (!fen.empty()) {
+        chess::Board board(fen);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = 0;
+        
+        if (divide) {
+            for (const auto& entry : board.divide(depth)) {
+                std::cout << entry.first.toAlgebraic() << ": " << entry.second << std::endl;
+                nodes += entry.second;
+            }
+        } else {
+            nodes = board.perft(depth);
+        }
+        
+        printResult("fen", depth, nodes, secondsSince(start));
+        std::cout << std::endl;
+        return 0;
+    }
+    
+    // reference suite, each position up to the requested depth
+    bool allPassed = true;
+    uint64_t totalNodes = 0;
+    auto suiteStart = std::chrono::steady_clock::now();
+    
+    for (const PerftPosition& position : referencePositions) {
+        chess::Board board(position.fen);
+        
+        for (int d = 1; d <= depth && d <= 6; d++) {
+            uint64_t expected = position.expected[d - 1];
+            if (expected == 0) {
+                break;
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = board.perft(d);
+            double seconds = secondsSince(start);
+            totalNodes += nodes;
+            
+            printResult(position.name, d, nodes, seconds);
+            if (nodes == expected) {
+                std::cout << "  ok" << std::endl;
+            } else {
+                std::cout << "  FAIL (expected " << expected << ")" << std::endl;
+                allPassed = false;
+            }
+        }
+    }
+    
+    printResult("total", depth, totalNodes, secondsSince(suiteStart));
+    std::cout << std::endl;
+    
+    return allPassed ? 0 : 1;
+}